@@ -498,6 +498,7 @@ struct SParser {  /* data to `f_parser' */
   ZIO *z;
   Mbuffer buff;  /* buffer to be used by the scanner */
   const char *name;
+  int trusted;  /* may load precompiled chunks */
 };
 
 static void f_parser (lua_State *L, void *ud) {
@@ -512,8 +513,13 @@ static void f_parser (lua_State *L, void *ud) {
                                                              &p->buff, p->name);
 #else
   if (c == LUA_SIGNATURE[0])
-		luaG_runerror(L, "invalid format, cannot load bytecode scripts");
-  tf = luaY_parser(L, p->z, &p->buff, p->name);
+  {
+    if (!p->trusted)
+      luaG_runerror(L, "invalid format, cannot load bytecode scripts");
+    tf = luaU_undump(L, p->z, &p->buff, p->name);
+  }
+  else
+    tf = luaY_parser(L, p->z, &p->buff, p->name);
 #endif
   cl = luaF_newLclosure(L, tf->nups, hvalue(gt(L)));
   cl->l.p = tf;
@@ -524,10 +530,11 @@ static void f_parser (lua_State *L, void *ud) {
 }
 
 
-int luaD_protectedparser (lua_State *L, ZIO *z, const char *name) {
+int luaD_protectedparser (lua_State *L, ZIO *z, const char *name,
+                          int trusted) {
   struct SParser p;
   int status;
-  p.z = z; p.name = name;
+  p.z = z; p.name = name; p.trusted = trusted;
   luaZ_initbuffer(L, &p.buff);
   status = luaD_pcall(L, f_parser, &p, savestack(L, L->top), L->errfunc);
   luaZ_freebuffer(L, &p.buff);
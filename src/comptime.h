@@ -0,0 +1,7 @@
+
+// Do not edit!  This file was autogenerated
+// by the ../comptime.sh script with git
+//
+const char* compbranch = "master";
+const char* comprevision = "20252c1d";
+const char* compnote = "user-029-fix-Keep-the-LUA_ClearState-comment-next-to-its-function";
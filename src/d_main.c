@@ -673,11 +673,17 @@ static void D_Display(void)
 	{
 		if (cv_netstat.value)
 		{
-			char s[50];
+			char s[96]; // the histogram line, with six INT32s at their longest
 			Net_GetNetStat();
 
 			s[sizeof s - 1] = '\0';
 
+			snprintf(s, sizeof s - 1, "64:%d 128:%d 256:%d 512:%d 1k:%d +:%d",
+				sendsizehist[0], sendsizehist[1], sendsizehist[2],
+				sendsizehist[3], sendsizehist[4], sendsizehist[5]);
+			V_DrawRightAlignedString(BASEVIDWIDTH, BASEVIDHEIGHT-ST_HEIGHT-60, V_YELLOWMAP, s);
+			snprintf(s, sizeof s - 1, "max packet %d b", sendmaxsize);
+			V_DrawRightAlignedString(BASEVIDWIDTH, BASEVIDHEIGHT-ST_HEIGHT-50, V_YELLOWMAP, s);
 			snprintf(s, sizeof s - 1, "get %d b/s", getbps);
 			V_DrawRightAlignedString(BASEVIDWIDTH, BASEVIDHEIGHT-ST_HEIGHT-40, V_YELLOWMAP, s);
 			snprintf(s, sizeof s - 1, "send %d b/s", sendbps);
@@ -912,7 +918,13 @@ void D_SRB2Loop(void)
 
 			if (elapsed > 0 && (INT64)capbudget > elapsed && !vsync_with_match_refresh)
 			{
-				I_SleepDuration(capbudget - (finishprecise - enterprecise));
+				// Collect Lua garbage in part of the time left
+				LUA_IdleStep(capbudget - elapsed);
+
+				finishprecise = I_GetPreciseTime();
+				elapsed = (INT64)(finishprecise - enterprecise);
+				if ((INT64)capbudget > elapsed)
+					I_SleepDuration(capbudget - elapsed);
 			}
 		}
 		// Capture the time once more to get the real delta time.
@@ -1549,7 +1561,7 @@ void D_SRB2Main(void)
 	R_Init();
 
 	// setting up sound
-	if (dedicated)
+	if (dedicated || M_CheckParm("-verifydemos"))
 	{
 		sound_disabled = true;
 		midi_disabled = digital_disabled = true;
@@ -1671,6 +1683,18 @@ void D_SRB2Main(void)
 		return;
 	}
 
+	// replay demos without drawing them, report whether they check out, and quit
+	if (M_CheckParm("-verifydemos") && M_IsNextParm())
+	{
+		const char **names = Z_Malloc(myargc * sizeof *names, PU_STATIC, NULL);
+		size_t numnames = 0;
+
+		while (M_IsNextParm())
+			names[numnames++] = M_GetNextParm();
+
+		G_VerifyDemos(names, numnames);
+	}
+
 	if (M_CheckParm("-ultimatemode"))
 	{
 		autostart = true;
@@ -26,6 +26,8 @@
 #include "i_joy.h"
 #include "g_input.h" // Game controls (for lua)
 #include "p_maputl.h" // P_PathTraverse constants (for lua)
+#include "z_zone.h"
+#include "fastcmp.h"
 
 #include "deh_tables.h"
 
@@ -5820,6 +5822,146 @@ struct int_const_s const INT_CONST[] = {
 	{NULL,0}
 };
 
+// Hashed name lookups for states and mobj types, so SOCs and Lua don't have
+// to compare against every name in the lists. Freeslots are picked up as they
+// get allocated, the first time a lookup happens after that.
+typedef struct
+{
+	INT32 *slots; // Index + 1 of the name in each slot, 0 if empty
+	UINT32 size; // Always a power of two
+	UINT32 count;
+} dehnamehash_t;
+
+typedef const char *(*dehnamegetter_t)(INT32 index);
+
+static dehnamehash_t builtinstatenames, freestatenames;
+static dehnamehash_t builtinmobjnames, freemobjnames;
+static INT32 numhashedfreestates, numhashedfreemobjs;
+
+static const char *BuiltinStateName(INT32 i) { return STATE_LIST[i] + 2; } // Skip S_
+static const char *FreeStateName(INT32 i) { return FREE_STATES[i]; }
+static const char *BuiltinMobjName(INT32 i) { return MOBJTYPE_LIST[i] + 3; } // Skip MT_
+static const char *FreeMobjName(INT32 i) { return FREE_MOBJS[i]; }
+
+static UINT32 DEH_HashName(const char *name)
+{
+	// FNV-1a
+	UINT32 hash = 0x811c9dc5;
+	for (; *name; name++)
+	{
+		hash ^= (UINT8)*name;
+		hash *= 0x01000193;
+	}
+	return hash;
+}
+
+static void DEH_NameHashInsert(dehnamehash_t *h, dehnamegetter_t getname, INT32 index)
+{
+	const char *name = getname(index);
+	UINT32 i;
+
+	if ((h->count + 1) * 2 > h->size)
+	{
+		dehnamehash_t old = *h;
+
+		h->size = old.size ? old.size * 2 : 1024;
+		h->slots = Z_Calloc(h->size * sizeof(INT32), PU_STATIC, NULL);
+		h->count = 0;
+
+		for (i = 0; i < old.size; i++)
+			if (old.slots[i])
+				DEH_NameHashInsert(h, getname, old.slots[i] - 1);
+
+		Z_Free(old.slots);
+	}
+
+	for (i = DEH_HashName(name) & (h->size - 1); h->slots[i]; i = (i + 1) & (h->size - 1))
+		if (fastcmp(name, getname(h->slots[i] - 1)))
+			return; // Keep the first one, like the old linear searches did
+
+	h->slots[i] = index + 1;
+	h->count++;
+}
+
+static INT32 DEH_NameHashFind(const dehnamehash_t *h, dehnamegetter_t getname, const char *name)
+{
+	UINT32 i;
+
+	if (!h->size)
+		return -1;
+
+	for (i = DEH_HashName(name) & (h->size - 1); h->slots[i]; i = (i + 1) & (h->size - 1))
+		if (fastcmp(name, getname(h->slots[i] - 1)))
+			return h->slots[i] - 1;
+
+	return -1;
+}
+
+/** Finds a state by name, without the S_ prefix.
+  * Freeslots take priority over the built-in states.
+  *
+  * \param name Name of the state.
+  * \return The state number, or -1 if there is no such state.
+  */
+INT32 DEH_FindState(const char *name)
+{
+	INT32 i;
+
+	if (!builtinstatenames.size)
+		for (i = 0; i < S_FIRSTFREESLOT; i++)
+			DEH_NameHashInsert(&builtinstatenames, BuiltinStateName, i);
+
+	// Freeslots are always allocated in order
+	while (numhashedfreestates < NUMSTATEFREESLOTS && FREE_STATES[numhashedfreestates])
+	{
+		DEH_NameHashInsert(&freestatenames, FreeStateName, numhashedfreestates);
+		numhashedfreestates++;
+	}
+
+	i = DEH_NameHashFind(&freestatenames, FreeStateName, name);
+	if (i != -1)
+		return S_FIRSTFREESLOT + i;
+
+	return DEH_NameHashFind(&builtinstatenames, BuiltinStateName, name);
+}
+
+/** Finds a mobj type by name, without the MT_ prefix.
+  * Freeslots take priority over the built-in mobj types.
+  *
+  * \param name Name of the mobj type.
+  * \return The mobj type, or -1 if there is no such mobj type.
+  */
+INT32 DEH_FindMobjType(const char *name)
+{
+	INT32 i;
+
+	if (!builtinmobjnames.size)
+		for (i = 0; i < MT_FIRSTFREESLOT; i++)
+			DEH_NameHashInsert(&builtinmobjnames, BuiltinMobjName, i);
+
+	while (numhashedfreemobjs < NUMMOBJFREESLOTS && FREE_MOBJS[numhashedfreemobjs])
+	{
+		DEH_NameHashInsert(&freemobjnames, FreeMobjName, numhashedfreemobjs);
+		numhashedfreemobjs++;
+	}
+
+	i = DEH_NameHashFind(&freemobjnames, FreeMobjName, name);
+	if (i != -1)
+		return MT_FIRSTFREESLOT + i;
+
+	return DEH_NameHashFind(&builtinmobjnames, BuiltinMobjName, name);
+}
+
+/// Forgets the freeslot names in the lookups, for when the freeslots get cleared.
+void DEH_ClearFreeslotNames(void)
+{
+	Z_Free(freestatenames.slots);
+	Z_Free(freemobjnames.slots);
+	memset(&freestatenames, 0, sizeof(freestatenames));
+	memset(&freemobjnames, 0, sizeof(freemobjnames));
+	numhashedfreestates = numhashedfreemobjs = 0;
+}
+
 // For this to work compile-time without being in this file,
 // this function would need to check sizes at runtime, without sizeof
 void DEH_TableCheck(void)
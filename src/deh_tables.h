@@ -31,6 +31,7 @@ extern bitarray_t used_spr[BIT_ARRAY_SIZE(NUMSPRITEFREESLOTS)]; // Sprite freesl
 	memset(FREE_SKINCOLORS, 0, sizeof(FREE_SKINCOLORS));\
 	memset(used_spr, 0, sizeof(used_spr));\
 	memset(actionsoverridden, LUA_REFNIL, sizeof(actionsoverridden));\
+	DEH_ClearFreeslotNames();\
 }
 
 struct flickytypes_s {
@@ -80,4 +81,8 @@ extern struct int_const_s const INT_CONST[];
 // Moved to this file because it can't work compile-time otherwise
 void DEH_TableCheck(void);
 
+INT32 DEH_FindState(const char *name);
+INT32 DEH_FindMobjType(const char *name);
+void DEH_ClearFreeslotNames(void);
+
 #endif
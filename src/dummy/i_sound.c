@@ -111,6 +111,11 @@ float I_GetSongPitch(void)
     return 0.0f;
 }
 
+void I_SetModFilter(INT32 filter)
+{
+    (void)filter;
+}
+
 /// ------------------------
 //  MUSIC SEEKING
 /// ------------------------
@@ -685,6 +685,59 @@ INT32 samepaths(const char *path1, const char *path2)
 // Directory loading
 //
 
+static int comparepaths(const void *a, const void *b)
+{
+	return strcmp(*(char * const *)a, *(char * const *)b);
+}
+
+// Lists the files of a directory, not its subdirectories, whose names end
+// with ext. Returns their paths sorted by name, allocated with Z_Malloc
+// like the array itself, or NULL if the directory can't be opened.
+char **getdirectoryfilesbyext(const char *path, const char *ext, size_t *count)
+{
+	DIR *dirhandle;
+	struct dirent *dent;
+	char **paths = NULL;
+	size_t numpaths = 0, maxpaths = 0;
+	const size_t extlen = strlen(ext);
+
+	*count = 0;
+
+	dirhandle = opendir(path);
+	if (dirhandle == NULL)
+		return NULL;
+
+	while ((dent = readdir(dirhandle)) != NULL)
+	{
+		const size_t len = strlen(dent->d_name);
+		char *fullpath;
+
+		if (len <= extlen || strcasecmp(dent->d_name + len - extlen, ext))
+			continue;
+
+		fullpath = va("%s" PATHSEP "%s", path, dent->d_name);
+		if (pathisdirectory(fullpath) != 0)
+			continue;
+
+		if (numpaths == maxpaths)
+		{
+			maxpaths = maxpaths ? maxpaths * 2 : 64;
+			paths = Z_Realloc(paths, maxpaths * sizeof *paths, PU_STATIC, NULL);
+		}
+		paths[numpaths++] = Z_StrDup(fullpath);
+	}
+
+	closedir(dirhandle);
+
+	if (numpaths)
+		qsort(paths, numpaths, sizeof *paths, comparepaths);
+	else
+		paths = Z_Malloc(sizeof *paths, PU_STATIC, NULL);
+
+	*count = numpaths;
+	return paths;
+}
+
 static void initdirpath(char *dirpath, size_t *dirpathindex, int depthleft)
 {
 	dirpathindex[depthleft] = strlen(dirpath) + 1;
@@ -38,6 +38,7 @@ extern int direrror;
 #endif
 
 lumpinfo_t *getdirectoryfiles(const char *path, UINT16 *nlmp, UINT16 *nfolders);
+char **getdirectoryfilesbyext(const char *path, const char *ext, size_t *count);
 
 #define menudepth 20
 
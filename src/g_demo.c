@@ -40,6 +40,18 @@
 #include "lua_hook.h"
 #include "md5.h" // demo checksums
 #include "netcode/d_netfil.h" // G_CheckDemoExtraFiles
+#include "netcode/d_netcmd.h" // cv_demokeyframes
+#include "p_saveg.h" // demo keyframes
+#include "r_fps.h" // R_ResetViewInterpolation
+#include "s_sound.h"
+#include "lzf.h"
+#include "filesrch.h" // G_VerifyDemos
+
+#ifdef UNIXCOMMON
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/wait.h>
+#endif
 
 boolean timingdemo; // if true, exit with report on completion
 boolean nodrawers; // for comparative timing purposes
@@ -54,6 +66,7 @@ demo_file_override_e demofileoverride;
 static UINT8 *demobuffer = NULL;
 static UINT8 *demo_p, *demotime_p;
 static UINT8 *demoend;
+static UINT8 *demoflags_p, *demotics_p; // for packing the tics when saving
 static UINT8 demoflags;
 UINT16 demoversion;
 boolean singledemo; // quit after playing a demo from cmdline
@@ -82,6 +95,30 @@ static struct {
 	mobj_t **hitlist;
 } ghostext;
 
+// Snapshots of the game taken during playback, so it can seek back.
+// They are net savegames, plus the little state of the demo reader.
+typedef struct
+{
+	UINT32 tic; // demo tics read before it
+	size_t demopos; // offset of demo_p
+	ticcmd_t oldcmd;
+	mobj_t oldghost;
+	UINT32 length; // of the savegame
+	UINT32 compressedlen; // 0 if stored as is
+	UINT8 *data;
+} demokeyframe_t;
+
+#define DEMOKEYFRAMESIZE (768*1024)
+
+static demokeyframe_t *keyframes = NULL;
+static size_t numkeyframes = 0, maxkeyframes = 0;
+static UINT32 nextkeyframetic; // demotic to save the next keyframe at
+static UINT32 demotic; // demo tics read so far
+
+static boolean demoverifying = false; // -verifydemos is playing a demo
+
+static void G_FreeDemoKeyframes(void);
+
 // Your naming conventions are stupid and useless.
 // There is no conflict here.
 typedef struct demoghost {
@@ -98,7 +135,7 @@ demoghost *ghosts = NULL;
 // DEMO RECORDING
 //
 
-#define DEMOVERSION 0x0013
+#define DEMOVERSION 0x0014
 #define DEMOHEADER  "\xF0" "SRB2Replay" "\x0F"
 
 #define DF_GHOST        0x01 // This demo contains ghost data too!
@@ -106,6 +143,7 @@ demoghost *ghosts = NULL;
 #define DF_NIGHTSATTACK 0x04 // This demo is from NiGHTS attack and contains its time left, score, and mares!
 #define DF_ATTACKMASK   0x06 // This demo is from ??? attack and contains ???
 #define DF_ATTACKSHIFT  1
+#define DF_COLUMNS      0x08 // The tics are stored by columns, see G_PackDemoTics
 
 // For demos
 #define ZT_FWD     0x01
@@ -195,6 +233,7 @@ void G_ReadDemoTiccmd(ticcmd_t *cmd, INT32 playernum)
 
 	G_CopyTiccmd(cmd, &oldcmd, 1);
 	players[playernum].angleturn = cmd->angleturn;
+	demotic++;
 
 	if (!(demoflags & DF_GHOST) && *demo_p == DEMOMARKER)
 	{
@@ -1404,6 +1443,390 @@ void G_WriteMetalTic(mobj_t *metal)
 	}
 }
 
+//
+// COLUMNAR TIC STORAGE
+//
+// Every tic interleaves the input and the ghost movement, so the same kind
+// of value only repeats every dozen bytes or so, which compresses poorly.
+// Saved demos regroup the fields into columns and compress each column.
+// Loading puts the rows back together before playback, so the readers
+// above never see the difference.
+//
+
+typedef enum
+{
+	DC_FLAGS, // ziptics, extra and follow flags
+	DC_MOVE, // forwardmove and sidemove
+	DC_ANGLE, // angleturn and aiming
+	DC_BUTTONS,
+	DC_POSITION, // ghost position, momentum and follow offsets
+	DC_SPRITE, // ghost angle, frame and sprites
+	DC_MISC, // anything rarer
+	NUMDEMOCOLUMNS
+} democolumn_t;
+
+typedef struct
+{
+	UINT8 *row, *rowend;
+	UINT8 *col[NUMDEMOCOLUMNS], *colend[NUMDEMOCOLUMNS];
+	boolean pack; // rows to columns, or the other way around
+	boolean error;
+} demowalk_t;
+
+// Moves one field between the current row and its column.
+// Returns the field as found in the row, or NULL if either ran out.
+static UINT8 *DemoField(demowalk_t *w, democolumn_t c, size_t size)
+{
+	UINT8 *field = w->row;
+
+	if (w->error || w->row + size > w->rowend || w->col[c] + size > w->colend[c])
+	{
+		w->error = true;
+		return NULL;
+	}
+
+	if (w->pack)
+		M_Memcpy(w->col[c], field, size);
+	else
+		M_Memcpy(field, w->col[c], size);
+
+	w->col[c] += size;
+	w->row += size;
+	return field;
+}
+
+static UINT8 DemoFlags(demowalk_t *w)
+{
+	UINT8 *field = DemoField(w, DC_FLAGS, 1);
+	return field ? *field : 0;
+}
+
+// Same layout as G_WriteDemoTiccmd
+static void WalkDemoTiccmd(demowalk_t *w)
+{
+	const UINT8 ziptic = DemoFlags(w);
+
+	if (ziptic & ZT_FWD)
+		DemoField(w, DC_MOVE, 1);
+	if (ziptic & ZT_SIDE)
+		DemoField(w, DC_MOVE, 1);
+	if (ziptic & ZT_ANGLE)
+		DemoField(w, DC_ANGLE, 2);
+	if (ziptic & ZT_BUTTONS)
+		DemoField(w, DC_BUTTONS, 2);
+	if (ziptic & ZT_AIMING)
+		DemoField(w, DC_ANGLE, 2);
+	if (ziptic & ZT_LATENCY)
+		DemoField(w, DC_MISC, 1);
+}
+
+// Same layout as G_WriteGhostTic
+static void WalkGhostTic(demowalk_t *w)
+{
+	const UINT8 ziptic = DemoFlags(w);
+
+	if (ziptic & GZT_XYZ)
+		DemoField(w, DC_POSITION, 3*sizeof(fixed_t));
+	else
+	{
+		if (ziptic & GZT_MOMXY)
+			DemoField(w, DC_POSITION, 2*sizeof(fixed_t));
+		if (ziptic & GZT_MOMZ)
+			DemoField(w, DC_POSITION, sizeof(fixed_t));
+	}
+	if (ziptic & GZT_ANGLE)
+		DemoField(w, DC_SPRITE, 1);
+	if (ziptic & GZT_FRAME)
+		DemoField(w, DC_SPRITE, 1);
+	if (ziptic & GZT_SPR2)
+		DemoField(w, DC_SPRITE, 2);
+
+	if (ziptic & GZT_EXTRA)
+	{
+		const UINT8 xziptic = DemoFlags(w);
+
+		if (xziptic & EZT_COLOR)
+			DemoField(w, DC_MISC, 2);
+		if (xziptic & EZT_SCALE)
+			DemoField(w, DC_MISC, sizeof(fixed_t));
+		if (xziptic & EZT_HIT)
+		{
+			UINT8 *field = DemoField(w, DC_MISC, 2);
+			UINT16 count = field ? READUINT16(field) : 0;
+
+			// type, health, x, y, z and angle
+			while (count-- && !w->error)
+				DemoField(w, DC_MISC, 4 + 2 + 3*sizeof(fixed_t) + sizeof(angle_t));
+		}
+		if (xziptic & EZT_SPRITE)
+			DemoField(w, DC_SPRITE, 2);
+		if (xziptic & EZT_HEIGHT)
+			DemoField(w, DC_MISC, sizeof(fixed_t));
+	}
+
+	if (ziptic & GZT_FOLLOW)
+	{
+		const UINT8 followtic = DemoFlags(w);
+
+		if (followtic & FZT_SPAWNED)
+		{
+			DemoField(w, DC_MISC, 2);
+			if (followtic & FZT_SKIN)
+				DemoField(w, DC_MISC, 1);
+		}
+		if (followtic & FZT_SCALE)
+			DemoField(w, DC_MISC, sizeof(fixed_t));
+		DemoField(w, DC_POSITION, 3*sizeof(fixed_t));
+		if (followtic & FZT_SKIN)
+			DemoField(w, DC_SPRITE, 2);
+		DemoField(w, DC_SPRITE, 2); // sprite
+		DemoField(w, DC_SPRITE, 1); // frame
+		DemoField(w, DC_MISC, 2); // color
+	}
+}
+
+// Positions are all fixed_t and mostly small momentums, so their high bytes
+// repeat a lot more once every byte of the value gets its own plane.
+static void SplitBytePlanes(const UINT8 *in, UINT8 *out, size_t length)
+{
+	const size_t count = length / sizeof(fixed_t);
+	size_t i, j;
+
+	for (i = 0; i < count; i++)
+		for (j = 0; j < sizeof(fixed_t); j++)
+			out[j*count + i] = in[i*sizeof(fixed_t) + j];
+}
+
+static void JoinBytePlanes(const UINT8 *in, UINT8 *out, size_t length)
+{
+	const size_t count = length / sizeof(fixed_t);
+	size_t i, j;
+
+	for (i = 0; i < count; i++)
+		for (j = 0; j < sizeof(fixed_t); j++)
+			out[i*sizeof(fixed_t) + j] = in[j*count + i];
+}
+
+#define DEMOCOLUMNSHEADER (8 + 8*NUMDEMOCOLUMNS)
+#define LZF_MAXRATIO 88 // a 3 byte back reference can stand for 264 bytes
+
+//
+// Packs the tics from tics up to the demo marker into columns.
+// Layout: number of tics, unpacked size of the tics, then each column's
+// length and compressed length (0 if stored as is), then the columns.
+// Returns the packed size, or 0 if packing doesn't help.
+//
+static size_t G_PackDemoTics(UINT8 *tics, UINT8 *ticsend, boolean ghost, UINT8 **packed)
+{
+	const size_t rawsize = ticsend - tics;
+	demowalk_t w;
+	UINT8 *columns, *out, *outend, *p;
+	UINT32 numtics = 0;
+	size_t i;
+
+	// No column can be longer than all the tics together,
+	// and one more of those is scratch space for the byte planes
+	columns = malloc(rawsize * (NUMDEMOCOLUMNS + 1));
+	out = malloc(DEMOCOLUMNSHEADER + rawsize);
+	if (!columns || !out)
+	{
+		free(columns);
+		free(out);
+		return 0;
+	}
+	outend = out + DEMOCOLUMNSHEADER + rawsize;
+
+	memset(&w, 0, sizeof w);
+	w.pack = true;
+	w.row = tics;
+	w.rowend = ticsend;
+	for (i = 0; i < NUMDEMOCOLUMNS; i++)
+	{
+		w.col[i] = columns + i*rawsize;
+		w.colend[i] = w.col[i] + rawsize;
+	}
+
+	while (!w.error && w.row < w.rowend && *w.row != DEMOMARKER)
+	{
+		WalkDemoTiccmd(&w);
+		if (ghost)
+			WalkGhostTic(&w);
+		numtics++;
+	}
+
+	// The recording must end on the marker, right after a whole tic
+	if (w.error || w.row + 1 != ticsend)
+	{
+		free(columns);
+		free(out);
+		return 0;
+	}
+
+	p = out;
+	WRITEUINT32(p, numtics);
+	WRITEUINT32(p, (UINT32)(rawsize - 1));
+	p += 8*NUMDEMOCOLUMNS; // column table, filled below
+
+	for (i = 0; i < NUMDEMOCOLUMNS && p < outend; i++)
+	{
+		UINT8 *col = columns + i*rawsize;
+		UINT8 *entry = out + 8 + 8*i;
+		const size_t length = w.col[i] - col;
+		size_t packedlen = 0;
+
+		if (i == DC_POSITION)
+		{
+			UINT8 *planes = columns + NUMDEMOCOLUMNS*rawsize;
+			SplitBytePlanes(col, planes, length);
+			col = planes;
+		}
+
+		if (length > 1)
+			packedlen = lzf_compress(col, length, p, min(length - 1, (size_t)(outend - p)));
+
+		if (packedlen)
+			p += packedlen;
+		else if (length <= (size_t)(outend - p))
+		{
+			M_Memcpy(p, col, length);
+			p += length;
+		}
+		else
+			p = outend;
+
+		WRITEUINT32(entry, (UINT32)length);
+		WRITEUINT32(entry, (UINT32)packedlen);
+	}
+
+	free(columns);
+
+	if (p >= outend || (size_t)(p - out) >= rawsize)
+	{
+		free(out);
+		return 0;
+	}
+
+	*packed = out;
+	return p - out;
+}
+
+//
+// Puts the rows of a columnar demo back together. tics points right after
+// the header, size is the size of the whole file. Returns a new buffer,
+// allocated with tag, holding the header and the unpacked tics, and frees
+// the old one. Returns NULL if the data is broken.
+//
+static UINT8 *G_UnpackDemoTics(UINT8 *buffer, UINT8 **tics, size_t size, boolean ghost, INT32 tag)
+{
+	const size_t headerlen = *tics - buffer;
+	UINT8 *p = *tics;
+	UINT8 *end = buffer + size;
+	UINT8 *columns[NUMDEMOCOLUMNS];
+	UINT8 *unpacked = NULL;
+	size_t length[NUMDEMOCOLUMNS], packedlen[NUMDEMOCOLUMNS];
+	size_t total = 0, totalstored = 0;
+	UINT32 numtics, rawsize;
+	demowalk_t w;
+	size_t i;
+
+	if (p + DEMOCOLUMNSHEADER > end)
+		return NULL;
+
+	numtics = READUINT32(p);
+	rawsize = READUINT32(p);
+	for (i = 0; i < NUMDEMOCOLUMNS; i++)
+	{
+		length[i] = READUINT32(p);
+		packedlen[i] = READUINT32(p);
+	}
+
+	// Check the column table before allocating anything: the columns must
+	// add up to the tics, be stored within the rest of the file, and not
+	// claim to be bigger than their compressed data can expand to
+	for (i = 0; i < NUMDEMOCOLUMNS; i++)
+	{
+		const size_t stored = packedlen[i] ? packedlen[i] : length[i];
+
+		if (length[i] > rawsize - total || stored > (size_t)(end - p) - totalstored)
+			return NULL;
+		if (packedlen[i] && length[i] / LZF_MAXRATIO > packedlen[i])
+			return NULL;
+
+		total += length[i];
+		totalstored += stored;
+	}
+
+	if (total != rawsize)
+		return NULL;
+
+	memset(columns, 0, sizeof columns);
+	memset(&w, 0, sizeof w);
+
+	for (i = 0; i < NUMDEMOCOLUMNS; i++)
+	{
+		const size_t stored = packedlen[i] ? packedlen[i] : length[i];
+
+		columns[i] = malloc(length[i] ? length[i] : 1);
+		if (!columns[i])
+			goto fail;
+
+		if (!packedlen[i])
+			M_Memcpy(columns[i], p, length[i]);
+		else if (lzf_decompress(p, packedlen[i], columns[i], length[i]) != length[i])
+			goto fail;
+		p += stored;
+
+		if (i == DC_POSITION && length[i])
+		{
+			UINT8 *planes = columns[i];
+
+			columns[i] = malloc(length[i]);
+			if (!columns[i])
+			{
+				columns[i] = planes;
+				goto fail;
+			}
+			JoinBytePlanes(planes, columns[i], length[i]);
+			free(planes);
+		}
+
+		w.col[i] = columns[i];
+		w.colend[i] = columns[i] + length[i];
+	}
+
+	unpacked = Z_Malloc(headerlen + rawsize + 1, tag, NULL);
+	M_Memcpy(unpacked, buffer, headerlen);
+
+	w.row = unpacked + headerlen;
+	w.rowend = w.row + rawsize;
+
+	while (numtics-- && !w.error)
+	{
+		WalkDemoTiccmd(&w);
+		if (ghost)
+			WalkGhostTic(&w);
+	}
+
+	if (w.error || w.row != w.rowend)
+		goto fail;
+
+	*w.row = DEMOMARKER;
+
+	for (i = 0; i < NUMDEMOCOLUMNS; i++)
+		free(columns[i]);
+
+	Z_Free(buffer);
+	*tics = unpacked + headerlen;
+	return unpacked;
+
+fail:
+	for (i = 0; i < NUMDEMOCOLUMNS; i++)
+		free(columns[i]);
+	if (unpacked)
+		Z_Free(unpacked);
+	return NULL;
+}
+
 //
 // G_RecordDemo
 //
@@ -1468,6 +1891,7 @@ void G_BeginRecording(void)
 	WRITEINT16(demo_p,gamemap);
 	M_Memcpy(demo_p, mapmd5, 16); demo_p += 16;
 
+	demoflags_p = demo_p;
 	WRITEUINT8(demo_p,demoflags);
 
 	// file list
@@ -1600,6 +2024,8 @@ void G_BeginRecording(void)
 	// Save netvar data
 	CV_SaveDemoVars(&demo_p);
 
+	demotics_p = demo_p;
+
 	memset(&oldcmd,0,sizeof(oldcmd));
 	memset(&oldghost,0,sizeof(oldghost));
 	memset(&ghostext,0,sizeof(ghostext));
@@ -2002,6 +2428,7 @@ void G_DoPlayDemo(char *defdemoname)
 	UINT32 randseed, followitem;
 	rnstate_t randstate;
 	fixed_t camerascale,shieldscale,actionspd,mindash,maxdash,normalspeed,runspeed,jumpfactor,height,spinheight;
+	size_t demosize;
 	char msg[1024];
 
 	// For compiler warnings
@@ -2022,7 +2449,7 @@ void G_DoPlayDemo(char *defdemoname)
 	if (FIL_CheckExtension(defdemoname))
 	{
 		//FIL_DefaultExtension(defdemoname, ".lmp");
-		if (!FIL_ReadFile(defdemoname, &demobuffer))
+		if (!(demosize = FIL_ReadFile(defdemoname, &demobuffer)))
 		{
 			snprintf(msg, 1024, M_GetText("Failed to read file '%s'.\n"), defdemoname);
 			CONS_Alert(CONS_ERROR, "%s", msg);
@@ -2042,7 +2469,10 @@ void G_DoPlayDemo(char *defdemoname)
 		return;
 	}
 	else // it's an internal demo
+	{
 		demobuffer = demo_p = W_CacheLumpNum(l, PU_STATIC);
+		demosize = W_LumpLength(l);
+	}
 
 	// read demo header
 	gameaction = ga_nothing;
@@ -2259,6 +2689,24 @@ void G_DoPlayDemo(char *defdemoname)
 #endif
 		CV_LoadDemoVars(&demo_p);
 
+	if (demoflags & DF_COLUMNS)
+	{
+		UINT8 *unpacked = G_UnpackDemoTics(demobuffer, &demo_p, demosize, (demoflags & DF_GHOST), PU_STATIC);
+
+		if (!unpacked)
+		{
+			snprintf(msg, 1024, M_GetText("%s is damaged and cannot be played.\n"), pdemoname);
+			CONS_Alert(CONS_ERROR, "%s", msg);
+			M_StartMessage(msg, NULL, MM_NOTHING);
+			Z_Free(pdemoname);
+			Z_Free(demobuffer);
+			demoplayback = false;
+			titledemo = false;
+			return;
+		}
+		demobuffer = unpacked;
+	}
+
 	// Sigh ... it's an empty demo.
 	if (*demo_p == DEMOMARKER)
 	{
@@ -2293,6 +2741,8 @@ void G_DoPlayDemo(char *defdemoname)
 
 	memset(&oldcmd,0,sizeof(oldcmd));
 	memset(&oldghost,0,sizeof(oldghost));
+	G_FreeDemoKeyframes();
+	demotic = 0;
 
 	if (VERSION != version || SUBVERSION != subversion)
 		CONS_Alert(CONS_WARNING, M_GetText("Demo version does not match game version. Desyncs may occur.\n"));
@@ -2441,6 +2891,7 @@ void G_AddGhost(char *defdemoname)
 	demoghost *gh;
 	UINT8 flags, subversion;
 	UINT8 *buffer,*p;
+	size_t size;
 	mapthing_t *mthing;
 	UINT16 count, ghostversion;
 
@@ -2460,7 +2911,7 @@ void G_AddGhost(char *defdemoname)
 	if (FIL_CheckExtension(defdemoname))
 	{
 		//FIL_DefaultExtension(defdemoname, ".lmp");
-		if (!FIL_ReadFileTag(defdemoname, &buffer, PU_LEVEL))
+		if (!(size = FIL_ReadFileTag(defdemoname, &buffer, PU_LEVEL)))
 		{
 			CONS_Alert(CONS_ERROR, M_GetText("Failed to read file '%s'.\n"), defdemoname);
 			Z_Free(pdemoname);
@@ -2476,7 +2927,10 @@ void G_AddGhost(char *defdemoname)
 		return;
 	}
 	else // it's an internal demo
+	{
 		buffer = p = W_CacheLumpNum(l, PU_LEVEL);
+		size = W_LumpLength(l);
+	}
 
 	// read demo header
 	if (memcmp(p, DEMOHEADER, 12))
@@ -2543,7 +2997,7 @@ void G_AddGhost(char *defdemoname)
 		break;
 	}
 
-	p += 4; // random seed
+	p += (ghostversion <= 0x0012) ? 4 : 16; // random seed, or random state
 
 	// Player name (TODO: Display this somehow if it doesn't match cv_playername!)
 	M_Memcpy(name, p,16);
@@ -2590,6 +3044,20 @@ void G_AddGhost(char *defdemoname)
 		}
 	}
 
+	if (flags & DF_COLUMNS)
+	{
+		UINT8 *unpacked = G_UnpackDemoTics(buffer, &p, size, true, PU_LEVEL);
+
+		if (!unpacked)
+		{
+			CONS_Alert(CONS_NOTICE, M_GetText("Failed to add ghost %s: Replay is damaged.\n"), pdemoname);
+			Z_Free(pdemoname);
+			Z_Free(buffer);
+			return;
+		}
+		buffer = unpacked;
+	}
+
 	if (*p == DEMOMARKER)
 	{
 		CONS_Alert(CONS_NOTICE, M_GetText("Failed to add ghost %s: Replay is empty.\n"), pdemoname);
@@ -2799,7 +3267,21 @@ static void G_StopDemoRecording(void)
 	boolean saved = false;
 	if (demo_p)
 	{
+		UINT8 *packed = NULL;
+		size_t packedsize;
+
 		WRITEUINT8(demo_p, DEMOMARKER); // add the demo end marker
+
+		// Store the tics by columns if that makes the file smaller
+		packedsize = G_PackDemoTics(demotics_p, demo_p, (demoflags & DF_GHOST), &packed);
+		if (packedsize)
+		{
+			*demoflags_p |= DF_COLUMNS;
+			M_Memcpy(demotics_p, packed, packedsize);
+			demo_p = demotics_p + packedsize;
+			free(packed);
+		}
+
 		WriteDemoChecksum();
 		saved = FIL_WriteFile(va(pandf, srb2home, demoname), demobuffer, demo_p - demobuffer); // finally output the file.
 	}
@@ -2903,12 +3385,548 @@ static void G_StopTimingDemo(void)
 	D_AdvanceDemo();
 }
 
+//
+// DEMO SEEKING
+//
+
+static void G_FreeDemoKeyframes(void)
+{
+	size_t i;
+
+	for (i = 0; i < numkeyframes; i++)
+		Z_Free(keyframes[i].data);
+
+	Z_Free(keyframes);
+	keyframes = NULL;
+	numkeyframes = maxkeyframes = 0;
+	nextkeyframetic = 0;
+}
+
+static void G_SaveDemoKeyframe(void)
+{
+	demokeyframe_t *kf;
+	UINT8 *savebuffer;
+	size_t length, compressedlen;
+	boolean saved;
+
+	savebuffer = malloc(DEMOKEYFRAMESIZE);
+	if (!savebuffer)
+		return;
+
+	save_p = savebuffer;
+	save_end = savebuffer + DEMOKEYFRAMESIZE;
+	saved = P_SaveNetGame(true);
+	length = save_p - savebuffer;
+	save_p = save_end = NULL;
+
+	// Too big to keep, seeking will go back to an earlier keyframe instead
+	if (!saved)
+	{
+		CONS_Debug(DBG_GAMELOGIC, "Dropped the demo keyframe at tic %u, it doesn't fit\n", demotic);
+		free(savebuffer);
+		return;
+	}
+
+	if (numkeyframes == maxkeyframes)
+	{
+		maxkeyframes = maxkeyframes ? maxkeyframes * 2 : 64;
+		keyframes = Z_Realloc(keyframes, maxkeyframes * sizeof (*keyframes), PU_STATIC, NULL);
+	}
+
+	kf = &keyframes[numkeyframes++];
+	kf->tic = demotic;
+	kf->demopos = demo_p - demobuffer;
+	kf->oldcmd = oldcmd;
+	kf->oldghost = oldghost;
+	kf->length = (UINT32)length;
+
+	// Keyframes pile up over a long demo, so keep them compressed
+	kf->data = Z_Malloc(length, PU_STATIC, NULL);
+	compressedlen = lzf_compress(savebuffer, length, kf->data, length - 1);
+
+	if (compressedlen)
+	{
+		kf->compressedlen = (UINT32)compressedlen;
+		kf->data = Z_Realloc(kf->data, compressedlen, PU_STATIC, NULL);
+	}
+	else
+	{
+		kf->compressedlen = 0;
+		M_Memcpy(kf->data, savebuffer, length);
+	}
+
+	free(savebuffer);
+}
+
+static boolean G_LoadDemoKeyframe(const demokeyframe_t *kf)
+{
+	UINT8 *savebuffer;
+	tic_t oldgametic = gametic;
+	boolean loaded;
+
+	if (kf->compressedlen)
+	{
+		savebuffer = Z_Malloc(kf->length, PU_STATIC, NULL);
+		if (lzf_decompress(kf->data, kf->compressedlen, savebuffer, kf->length) != kf->length)
+		{
+			Z_Free(savebuffer);
+			return false;
+		}
+	}
+	else
+		savebuffer = kf->data;
+
+	save_p = savebuffer;
+	loaded = P_LoadNetGame(true);
+	save_p = NULL;
+
+	if (savebuffer != kf->data)
+		Z_Free(savebuffer);
+
+	// The savegame has its own gametic, but the game clock must not go back
+	gametic = oldgametic;
+
+	if (!loaded)
+		return false;
+
+	demo_p = demobuffer + kf->demopos;
+	demotic = kf->tic;
+	oldcmd = kf->oldcmd;
+	oldghost = kf->oldghost;
+
+	return true;
+}
+
+// Called at the end of every tic in demo playback
+void G_DemoKeyframeTicker(void)
+{
+	const UINT32 interval = (UINT32)cv_demokeyframes.value * TICRATE;
+
+	// Nobody seeks in a timedemo or a verified demo, so don't slow them down
+	if (!interval || !demo_p || !demo_start || titledemo || timingdemo || demoverifying
+		|| gamestate != GS_LEVEL)
+		return;
+
+	// Only extend the index, tics before the last keyframe are covered
+	if (demotic < nextkeyframetic)
+		return;
+
+	// Even if this one is dropped, don't try again every tic
+	nextkeyframetic = demotic + interval;
+	G_SaveDemoKeyframe();
+}
+
+UINT32 G_DemoTic(void)
+{
+	return demotic;
+}
+
+// Jumps to a tic of the demo being played: back to the nearest keyframe
+// at or before it, then forward by running tics without drawing them.
+boolean G_SeekDemo(UINT32 target)
+{
+	const demokeyframe_t *kf = NULL;
+	UINT32 stalled = 0;
+	size_t i;
+
+	if (!demoplayback || !demo_start || titledemo || gamestate != GS_LEVEL)
+	{
+		CONS_Printf(M_GetText("You can only seek in a demo that is playing.\n"));
+		return false;
+	}
+
+	if (ghosts || metalplayback)
+	{
+		CONS_Printf(M_GetText("You can't seek while ghosts are playing.\n"));
+		return false;
+	}
+
+	if (paused)
+	{
+		CONS_Printf(M_GetText("You can't seek while the game is paused.\n"));
+		return false;
+	}
+
+	for (i = numkeyframes; i-- > 0;)
+	{
+		if (keyframes[i].tic <= target)
+		{
+			kf = &keyframes[i];
+			break;
+		}
+	}
+
+	// Before the first keyframe, the closest we can get is that keyframe
+	if (!kf && target < demotic)
+	{
+		if (!numkeyframes)
+		{
+			CONS_Printf(M_GetText("There is nothing to seek back to yet.\n"));
+			return false;
+		}
+		kf = &keyframes[0];
+	}
+
+	if (kf && (target < demotic || kf->tic > demotic))
+	{
+		if (!G_LoadDemoKeyframe(kf))
+		{
+			CONS_Alert(CONS_ERROR, M_GetText("Couldn't restore the demo keyframe.\n"));
+			G_CheckDemoStatus();
+			return false;
+		}
+	}
+
+	// Run the rest as fast as possible, stopping if the demo ends
+	// or somehow stops advancing
+	while (demoplayback && demotic < target && gamestate == GS_LEVEL && stalled < TICRATE)
+	{
+		const UINT32 before = demotic;
+
+		D_RunTic();
+
+		stalled = (demotic == before) ? stalled + 1 : 0;
+	}
+
+	if (!demoplayback)
+		return false;
+
+	// Whatever piled up while skipping shouldn't play at once
+	S_StopSounds();
+
+	if (camera.chase)
+		P_ResetCamera(&players[displayplayer], &camera);
+	R_ResetViewInterpolation(0);
+
+	return true;
+}
+
+//
+// DEMO VERIFICATION
+//
+// -verifydemos replays demos as fast as possible, without drawing, and checks
+// that they are intact, stay in sync with their ghost data, and (for record
+// attack) finish with the time they claim. Where fork() exists, each demo
+// plays in its own copy of the freshly started game, several at once.
+//
+
+typedef enum
+{
+	DV_PASS,
+	DV_UNREADABLE, // missing, not a replay, or it can't be played here
+	DV_CHECKSUM, // the file was altered after recording
+	DV_DESYNC,
+	DV_BADTIME, // the final time isn't the one in the header
+	DV_UNFINISHED, // playback stopped before the end of the data
+	DV_CRASHED,
+	NUMDEMOVERIFYSTATUS
+} demoverifystatus_t;
+
+static const char *const demoverifystatus[NUMDEMOVERIFYSTATUS] = {
+	"PASS",
+	"UNREADABLE",
+	"CHECKSUM",
+	"DESYNC",
+	"BADTIME",
+	"UNFINISHED",
+	"CRASHED",
+};
+
+typedef struct
+{
+	UINT8 status;
+	UINT32 tics;
+	tic_t time; // of player 0 when the demo ended
+	INT16 consistancy; // of the final state, to compare between builds
+	precise_t duration;
+} demoverifyresult_t;
+
+static boolean demoverifyended;
+
+#define MAXVERIFYJOBS 64
+
+static void G_VerifyDemo(const char *path, demoverifyresult_t *result)
+{
+	const precise_t start = I_GetPreciseTime();
+	UINT8 *buffer;
+	size_t size;
+	char *name;
+	boolean desynced = false;
+	UINT32 lasttic = 0, stalled = 0;
+
+	memset(result, 0, sizeof *result);
+	result->status = DV_UNREADABLE;
+
+	size = FIL_ReadFile(path, &buffer);
+	if (!size)
+		return;
+
+	if (size < 32 || memcmp(buffer, DEMOHEADER, 12))
+	{
+		Z_Free(buffer);
+		return;
+	}
+
+#ifndef NOMD5
+	{
+		UINT8 md5[16];
+
+		// Same as WriteDemoChecksum
+		md5_buffer((char *)buffer + 32, size - 32, md5);
+		if (memcmp(md5, buffer + 16, 16))
+		{
+			result->status = DV_CHECKSUM;
+			Z_Free(buffer);
+			return;
+		}
+	}
+#endif
+
+	Z_Free(buffer);
+
+	demoverifying = true;
+	demoverifyended = false;
+
+	name = Z_StrDup(path);
+	G_DoPlayDemo(name);
+	Z_Free(name);
+
+	// The intermission doesn't read tics, but it doesn't last a minute either
+	while (demoplayback && !demoverifyended && stalled < 60*TICRATE)
+	{
+		G_Ticker((gametic % NEWTICRATERATIO) == 0);
+		gametic++;
+		result->tics++;
+
+		// Loading the next map resets demosynced
+		if (!demosynced)
+			desynced = true;
+
+		stalled = (demotic == lasttic) ? stalled + 1 : 0;
+		lasttic = demotic;
+	}
+
+	if (result->tics)
+	{
+		result->time = players[0].realtime;
+		result->consistancy = Consistancy();
+
+		if (!demoverifyended)
+			result->status = DV_UNFINISHED;
+		else if (desynced)
+			result->status = DV_DESYNC;
+		else if (modeattacking == ATTACKING_RECORD && players[0].realtime != hu_demotime)
+			result->status = DV_BADTIME;
+		else
+			result->status = DV_PASS;
+	}
+
+	demoverifying = false;
+	if (demoplayback)
+		G_StopDemo();
+
+	result->duration = I_GetPreciseTime() - start;
+}
+
+#ifdef UNIXCOMMON
+typedef struct
+{
+	pid_t pid;
+	int fd; // the result comes through this pipe
+	size_t index;
+} demoverifyjob_t;
+
+static void G_VerifyDemosForked(char **paths, demoverifyresult_t *results, size_t numpaths, size_t jobs)
+{
+	demoverifyjob_t *running = Z_Calloc(jobs * sizeof *running, PU_STATIC, NULL);
+	size_t next = 0, numrunning = 0;
+	size_t i;
+
+	// Don't let the children inherit pending output
+	fflush(NULL);
+
+	while (next < numpaths || numrunning)
+	{
+		int status;
+		pid_t pid;
+
+		while (next < numpaths && numrunning < jobs)
+		{
+			int fds[2];
+
+			if (pipe(fds) < 0)
+			{
+				next++; // stays CRASHED
+				continue;
+			}
+
+			pid = fork();
+			if (pid == 0)
+			{
+				demoverifyresult_t result;
+
+				close(fds[0]);
+
+				// Several demos at once would garble the console
+				if (jobs > 1)
+				{
+					int null = open("/dev/null", O_WRONLY);
+					if (null >= 0)
+					{
+						dup2(null, STDOUT_FILENO);
+						dup2(null, STDERR_FILENO);
+					}
+				}
+
+				G_VerifyDemo(paths[next], &result);
+
+				if (write(fds[1], &result, sizeof result) != sizeof result)
+					_exit(1);
+				_exit(0); // without saving the config and gamedata on the way out
+			}
+
+			close(fds[1]);
+
+			if (pid < 0)
+			{
+				close(fds[0]);
+				next++;
+				continue;
+			}
+
+			running[numrunning].pid = pid;
+			running[numrunning].fd = fds[0];
+			running[numrunning].index = next++;
+			numrunning++;
+		}
+
+		if (!numrunning)
+			break;
+
+		pid = waitpid(-1, &status, 0);
+		if (pid < 0)
+			break;
+
+		for (i = 0; i < numrunning; i++)
+		{
+			demoverifyresult_t result;
+
+			if (running[i].pid != pid)
+				continue;
+
+			// A child that died before writing its result stays CRASHED
+			if (read(running[i].fd, &result, sizeof result) == sizeof result)
+				results[running[i].index] = result;
+
+			close(running[i].fd);
+			running[i] = running[--numrunning];
+			break;
+		}
+	}
+
+	Z_Free(running);
+}
+#endif
+
+void G_VerifyDemos(const char **names, size_t numnames)
+{
+	char **paths = NULL;
+	size_t numpaths = 0, maxpaths = 0;
+	demoverifyresult_t *results;
+	INT32 numjobs = 1;
+	size_t jobs;
+	size_t passed = 0;
+	precise_t start;
+	size_t i, j;
+
+	for (i = 0; i < numnames; i++)
+	{
+		char **found;
+		size_t numfound;
+
+		if (pathisdirectory(names[i]) == 1)
+			found = getdirectoryfilesbyext(names[i], ".lmp", &numfound);
+		else
+		{
+			found = Z_Malloc(sizeof *found, PU_STATIC, NULL);
+			found[0] = Z_StrDup(names[i]);
+			numfound = 1;
+		}
+
+		if (!found)
+		{
+			CONS_Alert(CONS_ERROR, M_GetText("Couldn't open directory %s\n"), names[i]);
+			continue;
+		}
+
+		if (numpaths + numfound > maxpaths)
+		{
+			maxpaths = numpaths + numfound;
+			paths = Z_Realloc(paths, maxpaths * sizeof *paths, PU_STATIC, NULL);
+		}
+		for (j = 0; j < numfound; j++)
+			paths[numpaths++] = found[j];
+
+		Z_Free(found);
+	}
+
+	if (!numpaths)
+		I_Error("No demos to verify");
+
+	if (M_CheckParm("-jobs") && M_IsNextParm())
+		numjobs = atoi(M_GetNextParm());
+#ifdef UNIXCOMMON
+	else
+		numjobs = (INT32)min(sysconf(_SC_NPROCESSORS_ONLN), MAXVERIFYJOBS); // -1 if unknown
+#endif
+	jobs = (size_t)max(1, min(numjobs, MAXVERIFYJOBS));
+
+	results = Z_Calloc(numpaths * sizeof *results, PU_STATIC, NULL);
+	for (i = 0; i < numpaths; i++)
+		results[i].status = DV_CRASHED;
+
+	CONS_Printf(M_GetText("Verifying %s demos...\n"), sizeu1(numpaths));
+
+	start = I_GetPreciseTime();
+#ifdef UNIXCOMMON
+	G_VerifyDemosForked(paths, results, numpaths, jobs);
+#else
+	jobs = 1;
+	for (i = 0; i < numpaths; i++)
+		G_VerifyDemo(paths[i], &results[i]);
+#endif
+
+	for (i = 0; i < numpaths; i++)
+	{
+		const demoverifyresult_t *result = &results[i];
+
+		if (result->status == DV_PASS)
+			passed++;
+
+		CONS_Printf("%-10s %8u tics %8.2fs  time %-8u consistancy %04x  %s\n",
+			demoverifystatus[result->status], result->tics,
+			(double)result->duration / I_GetPrecisePrecision(),
+			result->time, (UINT16)result->consistancy, paths[i]);
+	}
+
+	CONS_Printf(M_GetText("%s of %s demos passed in %.2fs with %s jobs\n"),
+		sizeu1(passed), sizeu2(numpaths),
+		(double)(I_GetPreciseTime() - start) / I_GetPrecisePrecision(),
+		sizeu3(jobs));
+
+	if (passed < numpaths)
+		I_Error("%s of %s demos failed verification", sizeu1(numpaths - passed), sizeu2(numpaths));
+
+	I_Quit();
+}
+
 // reset engine variable set for the demos
 // called from stopdemo command, map command, and g_checkdemoStatus.
 void G_StopDemo(void)
 {
 	Z_Free(demobuffer);
 	demobuffer = NULL;
+	G_FreeDemoKeyframes();
 	demoplayback = false;
 	titledemo = false;
 	timingdemo = false;
@@ -2939,6 +3957,13 @@ boolean G_CheckDemoStatus(void)
 
 	if (demoplayback)
 	{
+		if (demoverifying)
+		{
+			// G_VerifyDemo looks at the final state before stopping
+			demoverifyended = true;
+			return true;
+		}
+
 		if (singledemo)
 			I_Quit();
 		G_StopDemo();
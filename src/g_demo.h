@@ -114,8 +114,14 @@ void G_DoPlayMetal(void);
 void G_DoneLevelLoad(void);
 void G_StopMetalDemo(void);
 ATTRNORETURN void FUNCNORETURN G_StopMetalRecording(boolean kill);
+ATTRNORETURN void FUNCNORETURN G_VerifyDemos(const char **names, size_t numnames);
 void G_StopDemo(void);
 boolean G_CheckDemoStatus(void);
+
+// Seeking in demo playback
+void G_DemoKeyframeTicker(void);
+UINT32 G_DemoTic(void);
+boolean G_SeekDemo(UINT32 target);
 INT32 G_ConvertOldFrameFlags(INT32 frame);
 UINT8 G_CheckDemoForError(char *defdemoname);
 
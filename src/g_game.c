@@ -2202,6 +2202,10 @@ void G_Ticker(boolean run)
 			memset(player_name_changes, 0, sizeof player_name_changes);
 		}
 	}
+
+	// The tic is over, keep a keyframe to seek back to
+	if (demoplayback)
+		G_DemoKeyframeTicker();
 }
 
 //
@@ -34,6 +34,11 @@ int polygonArraySize = 0;
 UINT32* polygonIndexArray = NULL;// contains sorting pointers for polygonArray
 int polygonArrayAllocSize = 65536;
 
+// scratch space for the radix sort in HWR_RenderBatches, same size as polygonIndexArray
+static UINT32* polygonSortKeys = NULL;
+static UINT32* polygonSortTempKeys = NULL;
+static UINT32* polygonSortTempIndices = NULL;
+
 FOutVector* unsortedVertexArray = NULL;// contains unsorted vertices and texture coordinates from DrawPolygon
 int unsortedVertexArraySize = 0;
 int unsortedVertexArrayAllocSize = 65536;
@@ -52,6 +57,9 @@ void HWR_StartBatching(void)
 		finalVertexIndexArray = malloc(finalVertexArrayAllocSize * 3 * sizeof(UINT32));
 		polygonArray = malloc(polygonArrayAllocSize * sizeof(PolygonArrayEntry));
 		polygonIndexArray = malloc(polygonArrayAllocSize * sizeof(UINT32));
+		polygonSortKeys = malloc(polygonArrayAllocSize * sizeof(UINT32));
+		polygonSortTempKeys = malloc(polygonArrayAllocSize * sizeof(UINT32));
+		polygonSortTempIndices = malloc(polygonArrayAllocSize * sizeof(UINT32));
 		unsortedVertexArray = malloc(unsortedVertexArrayAllocSize * sizeof(FOutVector));
 	}
 
@@ -91,9 +99,15 @@ void HWR_ProcessPolygon(FSurfaceInfo *pSurf, FOutVector *pOutVerts, FUINT iNumPt
 			memcpy(new_array, polygonArray, polygonArraySize * sizeof(PolygonArrayEntry));
 			free(polygonArray);
 			polygonArray = new_array;
-			// also need to redo the index array, dont need to copy it though
+			// also need to redo the index and sorting arrays, dont need to copy them though
 			free(polygonIndexArray);
 			polygonIndexArray = malloc(polygonArrayAllocSize * sizeof(UINT32));
+			free(polygonSortKeys);
+			polygonSortKeys = malloc(polygonArrayAllocSize * sizeof(UINT32));
+			free(polygonSortTempKeys);
+			polygonSortTempKeys = malloc(polygonArrayAllocSize * sizeof(UINT32));
+			free(polygonSortTempIndices);
+			polygonSortTempIndices = malloc(polygonArrayAllocSize * sizeof(UINT32));
 		}
 
 		while (unsortedVertexArraySize + (int)iNumPts > unsortedVertexArrayAllocSize)
@@ -156,13 +170,62 @@ void HWR_ProcessPolygon(FSurfaceInfo *pSurf, FOutVector *pOutVerts, FUINT iNumPt
 	}
 }
 
-static int comparePolygons(const void *p1, const void *p2)
+// Sorts polygonIndexArray by ascending polygon hash with a LSD radix sort,
+// one byte per pass. The hash is signed (horizon lines and untextured polygons
+// use negative hashes so they come first), so the sign bit is flipped to get
+// an unsigned key with the same order. Unlike qsort this is stable, so polygons
+// with the same hash keep their submission order.
+static void sortPolygons(void)
 {
-	unsigned int index1 = *(const unsigned int*)p1;
-	unsigned int index2 = *(const unsigned int*)p2;
-	PolygonArrayEntry* poly1 = &polygonArray[index1];
-	PolygonArrayEntry* poly2 = &polygonArray[index2];
-	return poly1->hash - poly2->hash;
+	UINT32 *keys = polygonSortKeys, *indices = polygonIndexArray;
+	UINT32 *tempKeys = polygonSortTempKeys, *tempIndices = polygonSortTempIndices;
+	UINT32 counts[4][256];
+	int i, pass;
+
+	memset(counts, 0, sizeof(counts));
+	for (i = 0; i < polygonArraySize; i++)
+	{
+		UINT32 key = (UINT32)polygonArray[i].hash ^ 0x80000000u;
+		keys[i] = key;
+		indices[i] = i;
+		counts[0][key & 0xFF]++;
+		counts[1][(key >> 8) & 0xFF]++;
+		counts[2][(key >> 16) & 0xFF]++;
+		counts[3][key >> 24]++;
+	}
+
+	for (pass = 0; pass < 4; pass++)
+	{
+		UINT32 *count = counts[pass];
+		const int shift = pass * 8;
+		UINT32 offset = 0;
+		UINT32 *swap;
+
+		// every key has the same byte here, nothing to do for this pass
+		if (count[(keys[0] >> shift) & 0xFF] == (UINT32)polygonArraySize)
+			continue;
+
+		for (i = 0; i < 256; i++)
+		{
+			UINT32 c = count[i];
+			count[i] = offset;
+			offset += c;
+		}
+
+		for (i = 0; i < polygonArraySize; i++)
+		{
+			UINT32 dest = count[(keys[i] >> shift) & 0xFF]++;
+			tempKeys[dest] = keys[i];
+			tempIndices[dest] = indices[i];
+		}
+
+		swap = keys; keys = tempKeys; tempKeys = swap;
+		swap = indices; indices = tempIndices; tempIndices = swap;
+	}
+
+	// an odd number of non-skipped passes leaves the result in the scratch array
+	if (indices != polygonIndexArray)
+		memcpy(polygonIndexArray, indices, polygonArraySize * sizeof(UINT32));
 }
 
 // This function organizes the geometry collected by HWR_ProcessPolygon calls into batches and uses
@@ -183,8 +246,6 @@ void HWR_RenderBatches(void)
 	FSurfaceInfo currentSurfaceInfo;
 	FSurfaceInfo nextSurfaceInfo;
 
-	int i;
-
     if (!currently_batching)
 		I_Error("HWR_RenderBatches called without starting batching");
 
@@ -205,15 +266,10 @@ void HWR_RenderBatches(void)
 	ps_hw_numcalls.value.i = ps_hw_numverts.value.i = 0;
 	ps_hw_numshaders.value.i = ps_hw_numtextures.value.i
 		= ps_hw_numpolyflags.value.i = ps_hw_numcolors.value.i = 1;
-	// init polygonIndexArray
-	for (i = 0; i < polygonArraySize; i++)
-	{
-		polygonIndexArray[i] = i;
-	}
 
 	// sort polygons
 	PS_START_TIMING(ps_hw_batchsorttime);
-	qsort(polygonIndexArray, polygonArraySize, sizeof(unsigned int), comparePolygons);
+	sortPolygons();
 	PS_STOP_TIMING(ps_hw_batchsorttime);
 	// sort order
 	// 1. shader
@@ -243,7 +299,7 @@ void HWR_RenderBatches(void)
     else
 	    HWD.pfnSetTexture(currentTexture);
 
-	while (1)// note: remember handling notexture polyflag as having texture number 0 (also in comparePolygons)
+	while (1)// note: remember handling notexture polyflag as having texture number 0 (also in the polygon hash)
 	{
 		int firstIndex;
 		int lastIndex;
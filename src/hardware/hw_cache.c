@@ -1167,10 +1167,12 @@ void HWR_SetPalette(RGBA_t *palette)
 static void HWR_SetPaletteLookup(RGBA_t *palette)
 {
 	int r, g, b;
+	palettesearch_t search;
 	UINT8 *lut = Z_Malloc(
 		HWR_PALETTE_LUT_SIZE*HWR_PALETTE_LUT_SIZE*HWR_PALETTE_LUT_SIZE*sizeof(UINT8),
 		PU_STATIC, NULL);
 #define STEP_SIZE (256/HWR_PALETTE_LUT_SIZE)
+	V_InitPaletteSearch(&search, palette);
 	for (b = 0; b < HWR_PALETTE_LUT_SIZE; b++)
 	{
 		for (g = 0; g < HWR_PALETTE_LUT_SIZE; g++)
@@ -1178,7 +1180,7 @@ static void HWR_SetPaletteLookup(RGBA_t *palette)
 			for (r = 0; r < HWR_PALETTE_LUT_SIZE; r++)
 			{
 				lut[b*HWR_PALETTE_LUT_SIZE*HWR_PALETTE_LUT_SIZE+g*HWR_PALETTE_LUT_SIZE+r] =
-					NearestPaletteColor(r*STEP_SIZE, g*STEP_SIZE, b*STEP_SIZE, palette);
+					V_SearchPaletteColor(&search, r*STEP_SIZE, g*STEP_SIZE, b*STEP_SIZE);
 			}
 		}
 	}
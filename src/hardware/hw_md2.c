@@ -613,6 +613,139 @@ modelfound:
 #define SETBRIGHTNESS(brightness,r,g,b) \
 	brightness = (UINT8)(((1063*(UINT16)(r))/5000) + ((3576*(UINT16)(g))/5000) + ((361*(UINT16)(b))/5000))
 
+// Calculates the skincolor "gradient" colour that a blend pixel of the given brightness maps to.
+// This only depends on the brightness, so HWR_CreateBlendedTexture builds a table with it
+// once per texture instead of searching the skincolor ramp for every pixel.
+static RGBA_t HWR_GetBlendGradientColor(UINT16 brightness, INT32 skinnum, const UINT16 *translation, const UINT8 *cutoff, const UINT8 *colorbrightnesses, UINT8 translen)
+{
+	RGBA_t blendcolor, nextcolor;
+	UINT8 firsti, secondi, mul, mulmax;
+	INT32 r, g, b;
+	UINT8 i;
+
+	// Rainbow needs to find the closest match to the textures themselves, instead of matching brightnesses to other colors.
+	// Ensue horrible mess.
+	if (skinnum == TC_RAINBOW)
+	{
+		UINT16 brightdif = 256;
+		INT32 compare, m, d;
+
+		firsti = 0;
+
+		for (i = 0; i < translen; i++)
+		{
+			if (brightness > colorbrightnesses[i]) // don't allow greater matches (because calculating a makeshift gradient for this is already a huge mess as is)
+				continue;
+
+			compare = abs((INT16)(colorbrightnesses[i]) - (INT16)(brightness));
+
+			if (compare < brightdif)
+			{
+				brightdif = (UINT16)compare;
+				firsti = i; // best matching color that's equal brightness or darker
+			}
+		}
+
+		secondi = firsti+1; // next color in line
+		if (secondi >= translen)
+		{
+			m = (INT16)brightness; // - 0;
+			d = (INT16)colorbrightnesses[firsti]; // - 0;
+		}
+		else
+		{
+			m = (INT16)brightness - (INT16)colorbrightnesses[secondi];
+			d = (INT16)colorbrightnesses[firsti] - (INT16)colorbrightnesses[secondi];
+		}
+
+		if (m >= d)
+			m = d-1;
+
+		mulmax = 16;
+
+		// calculate the "gradient" multiplier based on how close this color is to the one next in line
+		if (m <= 0 || d <= 0)
+			mul = 0;
+		else
+			mul = (mulmax-1) - ((m * mulmax) / d);
+	}
+	else
+	{
+		// Just convert brightness to a skincolor value, use distance to next position to find the gradient multipler
+		firsti = 0;
+
+		for (i = 1; i < translen; i++)
+		{
+			if (brightness >= cutoff[i])
+				break;
+			firsti = i;
+		}
+
+		secondi = firsti+1;
+
+		mulmax = cutoff[firsti];
+		if (secondi < translen)
+			mulmax -= cutoff[secondi];
+
+		mul = cutoff[firsti] - brightness;
+	}
+
+	blendcolor = V_GetColor(translation[firsti]);
+
+	if (secondi >= translen)
+		mul = 0;
+
+	if (mul > 0 && mulmax > 0) // If it's 0, then we only need the first color.
+	{
+#if 0
+		if (secondi >= translen)
+		{
+			// blend to black
+			nextcolor = V_GetColor(31);
+		}
+		else
+#endif
+			nextcolor = V_GetColor(translation[secondi]);
+
+		// Find difference between points
+		r = (INT32)(nextcolor.s.red - blendcolor.s.red);
+		g = (INT32)(nextcolor.s.green - blendcolor.s.green);
+		b = (INT32)(nextcolor.s.blue - blendcolor.s.blue);
+
+		// Find the gradient of the two points
+		r = ((mul * r) / mulmax);
+		g = ((mul * g) / mulmax);
+		b = ((mul * b) / mulmax);
+
+		// Add gradient value to color
+		blendcolor.s.red += r;
+		blendcolor.s.green += g;
+		blendcolor.s.blue += b;
+	}
+
+	if (skinnum == TC_RAINBOW)
+	{
+		// Rainbow keeps the brightness of the texture, so scale the colour to it here
+		UINT32 tempcolor;
+		UINT16 colorbright;
+
+		SETBRIGHTNESS(colorbright,blendcolor.s.red,blendcolor.s.green,blendcolor.s.blue);
+		if (colorbright == 0)
+			colorbright = 1; // no dividing by 0 please
+
+		tempcolor = (brightness * blendcolor.s.red) / colorbright;
+		blendcolor.s.red = (UINT8)min(255, tempcolor);
+
+		tempcolor = (brightness * blendcolor.s.green) / colorbright;
+		blendcolor.s.green = (UINT8)min(255, tempcolor);
+
+		tempcolor = (brightness * blendcolor.s.blue) / colorbright;
+		blendcolor.s.blue = (UINT8)min(255, tempcolor);
+	}
+
+	return blendcolor;
+}
+
 static void HWR_CreateBlendedTexture(patch_t *gpatch, patch_t *blendgpatch, GLMipmap_t *grMipmap, INT32 skinnum, skincolornum_t color)
 {
 	GLPatch_t *hwrPatch = gpatch->hardware;
@@ -620,12 +753,12 @@ static void HWR_CreateBlendedTexture(patch_t *gpatch, patch_t *blendgpatch, GLMi
 	UINT16 w = gpatch->width, h = gpatch->height;
 	UINT32 size = w*h;
 	RGBA_t *image, *blendimage, *cur, blendcolor;
+	RGBA_t gradient[256]; // Skincolor gradient colour for every blend brightness
 	UINT16 translation[16]; // First the color index
 	UINT8 cutoff[16]; // Brightness cutoff before using the next color
 	UINT8 translen = 0;
 	UINT8 i;
 
-	blendcolor = V_GetColor(0); // initialize
 	memset(translation, 0, sizeof(translation));
 	memset(cutoff, 0, sizeof(cutoff));
 
@@ -686,6 +819,21 @@ static void HWR_CreateBlendedTexture(patch_t *gpatch, patch_t *blendgpatch, GLMi
 		translen++;
 	}
 
+	if (translen > 0 && blendimage != NULL && skinnum != TC_ALLWHITE && skinnum != TC_DASHMODE)
+	{
+		UINT8 colorbrightnesses[16];
+		UINT16 brightness;
+
+		for (i = 0; i < translen; i++)
+		{
+			RGBA_t tempc = V_GetColor(translation[i]);
+			SETBRIGHTNESS(colorbrightnesses[i], tempc.s.red, tempc.s.green, tempc.s.blue); // store brightnesses for comparison
+		}
+
+		for (brightness = 0; brightness < 256; brightness++)
+			gradient[brightness] = HWR_GetBlendGradientColor(brightness, skinnum, translation, cutoff, colorbrightnesses, translen);
+	}
+
 	while (size--)
 	{
 		if (skinnum == TC_ALLWHITE)
@@ -764,183 +912,45 @@ static void HWR_CreateBlendedTexture(patch_t *gpatch, patch_t *blendgpatch, GLMi
 						// slightly dumb average between the blend image color and base image colour, usually one or the other will be fully opaque anyway
 						brightness = (imagebright*(255-blendimage->s.alpha))/255 + (blendbright*blendimage->s.alpha)/255;
 					}
-				}
-				else
-				{
-					if (blendimage->s.alpha == 0)
-					{
-						cur->rgba = image->rgba;
-						goto skippixel; // for metal sonic blend
-					}
-					else
-					{
-						SETBRIGHTNESS(brightness,blendimage->s.red,blendimage->s.green,blendimage->s.blue);
-					}
-				}
-
-				// Calculate a sort of "gradient" for the skincolor
-				// (Me splitting this into a function didn't work, so I had to ruin this entire function's groove...)
-				{
-					RGBA_t nextcolor;
-					UINT8 firsti, secondi, mul, mulmax;
-					INT32 r, g, b;
-
-					// Rainbow needs to find the closest match to the textures themselves, instead of matching brightnesses to other colors.
-					// Ensue horrible mess.
-					if (skinnum == TC_RAINBOW)
-					{
-						UINT16 brightdif = 256;
-						UINT8 colorbrightnesses[16];
-						INT32 compare, m, d;
-
-						// Ignore pure white & pitch black
-						if (brightness > 253 || brightness < 2)
-						{
-							cur->rgba = image->rgba;
-							cur++; image++; blendimage++;
-							continue;
-						}
-
-						firsti = 0;
-						mul = 0;
-						mulmax = 1;
-
-						for (i = 0; i < translen; i++)
-						{
-							RGBA_t tempc = V_GetColor(translation[i]);
-							SETBRIGHTNESS(colorbrightnesses[i], tempc.s.red, tempc.s.green, tempc.s.blue); // store brightnesses for comparison
-						}
-
-						for (i = 0; i < translen; i++)
-						{
-							if (brightness > colorbrightnesses[i]) // don't allow greater matches (because calculating a makeshift gradient for this is already a huge mess as is)
-								continue;
-
-							compare = abs((INT16)(colorbrightnesses[i]) - (INT16)(brightness));
-
-							if (compare < brightdif)
-							{
-								brightdif = (UINT16)compare;
-								firsti = i; // best matching color that's equal brightness or darker
-							}
-						}
-
-						secondi = firsti+1; // next color in line
-						if (secondi >= translen)
-						{
-							m = (INT16)brightness; // - 0;
-							d = (INT16)colorbrightnesses[firsti]; // - 0;
-						}
-						else
-						{
-							m = (INT16)brightness - (INT16)colorbrightnesses[secondi];
-							d = (INT16)colorbrightnesses[firsti] - (INT16)colorbrightnesses[secondi];
-						}
-
-						if (m >= d)
-							m = d-1;
-
-						mulmax = 16;
-
-						// calculate the "gradient" multiplier based on how close this color is to the one next in line
-						if (m <= 0 || d <= 0)
-							mul = 0;
-						else
-							mul = (mulmax-1) - ((m * mulmax) / d);
-					}
-					else
-					{
-						// Just convert brightness to a skincolor value, use distance to next position to find the gradient multipler
-						firsti = 0;
-
-						for (i = 1; i < translen; i++)
-						{
-							if (brightness >= cutoff[i])
-								break;
-							firsti = i;
-						}
-
-						secondi = firsti+1;
-
-						mulmax = cutoff[firsti];
-						if (secondi < translen)
-							mulmax -= cutoff[secondi];
-
-						mul = cutoff[firsti] - brightness;
-					}
 
-					blendcolor = V_GetColor(translation[firsti]);
-
-					if (secondi >= translen)
-						mul = 0;
-
-					if (mul > 0) // If it's 0, then we only need the first color.
+					// Ignore pure white & pitch black
+					if (brightness > 253 || brightness < 2)
 					{
-#if 0
-						if (secondi >= translen)
-						{
-							// blend to black
-							nextcolor = V_GetColor(31);
-						}
-						else
-#endif
-							nextcolor = V_GetColor(translation[secondi]);
-
-						// Find difference between points
-						r = (INT32)(nextcolor.s.red - blendcolor.s.red);
-						g = (INT32)(nextcolor.s.green - blendcolor.s.green);
-						b = (INT32)(nextcolor.s.blue - blendcolor.s.blue);
-
-						// Find the gradient of the two points
-						r = ((mul * r) / mulmax);
-						g = ((mul * g) / mulmax);
-						b = ((mul * b) / mulmax);
-
-						// Add gradient value to color
-						blendcolor.s.red += r;
-						blendcolor.s.green += g;
-						blendcolor.s.blue += b;
+						cur->rgba = image->rgba;
+						cur++; image++; blendimage++;
+						continue;
 					}
-				}
 
-				if (skinnum == TC_RAINBOW)
-				{
-					UINT32 tempcolor;
-					UINT16 colorbright;
-
-					SETBRIGHTNESS(colorbright,blendcolor.s.red,blendcolor.s.green,blendcolor.s.blue);
-					if (colorbright == 0)
-						colorbright = 1; // no dividing by 0 please
-
-					tempcolor = (brightness * blendcolor.s.red) / colorbright;
-					tempcolor = min(255, tempcolor);
-					cur->s.red = (UINT8)tempcolor;
-
-					tempcolor = (brightness * blendcolor.s.green) / colorbright;
-					tempcolor = min(255, tempcolor);
-					cur->s.green = (UINT8)tempcolor;
-
-					tempcolor = (brightness * blendcolor.s.blue) / colorbright;
-					tempcolor = min(255, tempcolor);
-					cur->s.blue = (UINT8)tempcolor;
+					// The gradient table already holds the final colour for rainbow
+					blendcolor = gradient[brightness];
+					cur->s.red = blendcolor.s.red;
+					cur->s.green = blendcolor.s.green;
+					cur->s.blue = blendcolor.s.blue;
 					cur->s.alpha = image->s.alpha;
 				}
 				else
 				{
 					// Color strength depends on image alpha
+					UINT8 ialpha = 255 - blendimage->s.alpha, balpha = blendimage->s.alpha;
 					INT32 tempcolor;
 
-					tempcolor = ((image->s.red * (255-blendimage->s.alpha)) / 255) + ((blendcolor.s.red * blendimage->s.alpha) / 255);
-					tempcolor = min(255, tempcolor);
-					cur->s.red = (UINT8)tempcolor;
+					if (balpha == 0)
+					{
+						cur->rgba = image->rgba;
+						goto skippixel; // for metal sonic blend
+					}
+
+					SETBRIGHTNESS(brightness,blendimage->s.red,blendimage->s.green,blendimage->s.blue);
+					blendcolor = gradient[brightness];
+
+					tempcolor = ((image->s.red * ialpha) / 255) + ((blendcolor.s.red * balpha) / 255);
+					cur->s.red = (UINT8)min(255, tempcolor);
 
-					tempcolor = ((image->s.green * (255-blendimage->s.alpha)) / 255) + ((blendcolor.s.green * blendimage->s.alpha) / 255);
-					tempcolor = min(255, tempcolor);
-					cur->s.green = (UINT8)tempcolor;
+					tempcolor = ((image->s.green * ialpha) / 255) + ((blendcolor.s.green * balpha) / 255);
+					cur->s.green = (UINT8)min(255, tempcolor);
 
-					tempcolor = ((image->s.blue * (255-blendimage->s.alpha)) / 255) + ((blendcolor.s.blue * blendimage->s.alpha) / 255);
-					tempcolor = min(255, tempcolor);
-					cur->s.blue = (UINT8)tempcolor;
+					tempcolor = ((image->s.blue * ialpha) / 255) + ((blendcolor.s.blue * balpha) / 255);
+					cur->s.blue = (UINT8)min(255, tempcolor);
 					cur->s.alpha = image->s.alpha;
 				}
 
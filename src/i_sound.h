@@ -149,6 +149,8 @@ float I_GetSongSpeed(void);
 void I_SetSongPitch(float pitch);
 float I_GetSongPitch(void);
 
+void I_SetModFilter(INT32 filter);
+
 /// ------------------------
 //  MUSIC SEEKING
 /// ------------------------
@@ -120,6 +120,16 @@ ENUM (STRING_HOOK);
 
 extern boolean hook_cmd_running;
 
+/*
+One bit per mobj hook type, set if a hook of that type can run for an mobj
+type (generic hooks set the bit for every type). Hot call sites test this
+inline, so mobjs nobody hooked don't go through the hook machinery at all.
+*/
+extern UINT32 mobjHookMask[NUMMOBJTYPES];
+
+#define LUA_HasMobjHook(mobj, name) \
+	(mobjHookMask[(mobj)->type] & (1u << MOBJ_HOOK(name)))
+
 void LUA_HookVoid(int hook);
 void LUA_HookHUD(int hook, huddrawlist_h drawlist);
 int  LUA_HookIntermissionThinker(boolean pstagefailed, INT32 intertic, INT32 tallydonetic, INT32 endtic);
@@ -23,6 +23,7 @@
 #include "lua_libs.h"
 #include "lua_hook.h"
 #include "lua_hud.h" // hud_running errors
+#include "lua_profile.h"
 
 #include "m_perfstats.h"
 #include "netcode/d_netcmd.h" // for cv_perfstats
@@ -56,6 +57,8 @@ static hook_t hookIds[HOOK(MAX)];
 static hook_t hudHookIds[HUD_HOOK(MAX)];
 static hook_t mobjHookIds[NUMMOBJTYPES][MOBJ_HOOK(MAX)];
 
+UINT32 mobjHookMask[NUMMOBJTYPES];
+
 // Lua tables are used to lookup string hook ids.
 static stringhook_t stringHooks[STRING_HOOK(MAX)];
 
@@ -168,10 +171,19 @@ static void add_hook(hook_t *map)
 static void add_mobj_hook(lua_State *L, int hook_type)
 {
 	mobjtype_t   mobj_type = luaL_optnumber(L, 3, MT_NULL);
+	mobjtype_t   i;
 
 	luaL_argcheck(L, mobj_type < NUMMOBJTYPES, 3, "invalid mobjtype_t");
 
 	add_hook(&mobjHookIds[mobj_type][hook_type]);
+
+	if (mobj_type == MT_NULL)
+	{
+		for (i = 0; i < NUMMOBJTYPES; ++i)
+			mobjHookMask[i] |= 1u << hook_type;
+	}
+	else
+		mobjHookMask[mobj_type] |= 1u << hook_type;
 }
 
 static void add_hud_hook(lua_State *L, int idx)
@@ -499,7 +511,19 @@ static int call_string_hooks(Hook_State *hook)
 
 static int call_mobj_type_hooks(Hook_State *hook, mobjtype_t mobj_type)
 {
-	return call_mapped(hook, &mobjHookIds[mobj_type][hook->hook_type]);
+	const hook_t *map = &mobjHookIds[mobj_type][hook->hook_type];
+	INT32 profdepth;
+	int calls;
+
+	if (map->numHooks == 0)
+		return 0;
+
+	/* generic hooks are attributed to the type they ran for too */
+	profdepth = LUA_PROFILE_ENTER(LPROF_MOBJTYPE, NULL, hook->mobj_type);
+	calls = call_mapped(hook, map);
+	LUA_PROFILE_LEAVE(profdepth);
+
+	return calls;
 }
 
 static void call_hud_hooks
@@ -508,11 +532,16 @@ static void call_hud_hooks
 		int        results,
 		Hook_Callback results_handler
 ){
+	const INT32 profdepth =
+		LUA_PROFILE_ENTER(LPROF_HUDHOOK, hudHookNames[hook->hook_type], 0);
+
 	hud_running = true; // local hook
 	init_hook_call(hook, results, results_handler);
 	call_mapped(hook, &hudHookIds[hook->hook_type]);
 	hud_running = false;
 
+	LUA_PROFILE_LEAVE(profdepth);
+
 	lua_pushnil(gL);
 	lua_setfield(gL, LUA_REGISTRYINDEX, "HUD_DRAW_LIST");
 }
@@ -524,15 +553,19 @@ static int call_hooks
 		Hook_Callback results_handler
 ){
 	int calls = 0;
+	INT32 profdepth;
 
 	init_hook_call(hook, results, results_handler);
 
 	if (hook->string)
 	{
+		profdepth = LUA_PROFILE_ENTER(LPROF_HOOK, stringHookNames[hook->hook_type], 0);
 		calls += call_string_hooks(hook);
 	}
 	else if (hook->mobj_type > 0)
 	{
+		profdepth = LUA_PROFILE_ENTER(LPROF_HOOK, mobjHookNames[hook->hook_type], 0);
+
 		/* call generic mobj hooks first */
 		calls += call_mobj_type_hooks(hook, MT_NULL);
 
@@ -542,7 +575,12 @@ static int call_hooks
 		ps_lua_mobjhooks.value.i += calls;
 	}
 	else
+	{
+		profdepth = LUA_PROFILE_ENTER(LPROF_HOOK, hookNames[hook->hook_type], 0);
 		calls += call_mapped(hook, &hookIds[hook->hook_type]);
+	}
+
+	LUA_PROFILE_LEAVE(profdepth);
 
 	lua_settop(gL, 0);
 
@@ -727,6 +765,8 @@ static void hook_think_frame(int type)
 
 	if (prepare_hook(&hook, 0, type))
 	{
+		const INT32 profdepth = LUA_PROFILE_ENTER(LPROF_HOOK, hookNames[type], 0);
+
 		init_hook_call(&hook, 0, res_none);
 
 		for (k = 0; k < map->numHooks; ++k)
@@ -757,6 +797,8 @@ static void hook_think_frame(int type)
 			}
 		}
 
+		LUA_PROFILE_LEAVE(profdepth);
+
 		lua_settop(gL, 0);
 	}
 }
@@ -990,6 +1032,8 @@ void LUA_HookNetArchive(lua_CFunction archFunc)
 	/* this is a remarkable case where the stack isn't reset */
 	if (map->numHooks > 0)
 	{
+		const INT32 profdepth = LUA_PROFILE_ENTER(LPROF_HOOK, hookNames[HOOK(NetVars)], 0);
+
 		// stack: tables
 		I_Assert(lua_gettop(gL) > 0);
 		I_Assert(lua_istable(gL, -1));
@@ -1007,6 +1051,8 @@ void LUA_HookNetArchive(lua_CFunction archFunc)
 		init_hook_call(&hook, 0, res_none);
 		call_mapped(&hook, map);
 
+		LUA_PROFILE_LEAVE(profdepth);
+
 		lua_pop(gL, 1); // pop archFunc
 		lua_remove(gL, EINDEX); // pop error handler
 		// stack: tables
@@ -1222,6 +1268,8 @@ int LUA_HookMusicChange(const char *oldname, struct MusicChange *param)
 
 	if (prepare_hook(&hook, false, type))
 	{
+		const INT32 profdepth = LUA_PROFILE_ENTER(LPROF_HOOK, hookNames[type], 0);
+
 		init_hook_call(&hook, 6, res_musicchange);
 		hook.values = 7;/* values pushed later */
 		hook.userdata = param;
@@ -1244,6 +1292,8 @@ int LUA_HookMusicChange(const char *oldname, struct MusicChange *param)
 			call_single_hook_no_copy(&hook);
 		}
 
+		LUA_PROFILE_LEAVE(profdepth);
+
 		lua_settop(gL, 0);
 	}
 
@@ -0,0 +1,434 @@
+// SONIC ROBO BLAST 2
+//-----------------------------------------------------------------------------
+// Copyright (C) 2024 by Sonic Team Junior.
+//
+// This program is free software distributed under the
+// terms of the GNU General Public License, version 2.
+// See the 'LICENSE' file for more details.
+//-----------------------------------------------------------------------------
+/// \file  lua_profile.c
+/// \brief Per-hook and per-function Lua profiler
+///
+/// Call and return events from the Lua VM maintain a shadow call stack,
+/// whose frames are nodes of a call tree. The time between two events
+/// is charged to the frame on top, so each node accumulates its self time.
+/// Hooks push synthetic frames (hook name, HUD hook name, mobj type)
+/// at the root of the tree, so the same function called from two hooks
+/// shows up twice, once below each of them.
+
+#include "doomdef.h"
+#include "d_main.h" // srb2home
+#include "command.h"
+#include "console.h"
+#include "deh_tables.h" // MOBJTYPE_LIST, FREE_MOBJS
+#include "i_system.h" // I_GetPreciseTime
+#include "z_zone.h"
+#include "uthash.h"
+
+#include "lua_script.h"
+#include "lua_libs.h"
+#include "lua_profile.h"
+
+#define LPROF_FUNC     (LPROF_MOBJTYPE + 1) // Lua or C function
+#define LPROF_UNHOOKED (LPROF_MOBJTYPE + 2) // Lua ran outside of any hook
+
+#define MAXPROFDEPTH 256
+
+typedef struct
+{
+	INT32 parent;
+	INT32 kind;
+	const void *id;
+} lprofkey_t;
+
+typedef struct
+{
+	lprofkey_t key;
+	INT32 index;
+	INT32 parent;
+	char *label;
+	precise_t selftime;
+	UINT32 calls;
+	UT_hash_handle hh;
+} lprofnode_t;
+
+boolean lua_profiling = false;
+
+static lprofnode_t *nodemap = NULL;
+static lprofnode_t **nodes = NULL;
+static INT32 numnodes = 0;
+static INT32 maxnodes = 0;
+
+static INT32 stack[MAXPROFDEPTH];
+static INT32 depth = 0;
+static INT32 overflow = 0; // frames that did not fit on the stack
+
+static precise_t lastswitch;
+
+// Charges the time since the last event to the frame on top
+static void ChargeTop(void)
+{
+	precise_t now = I_GetPreciseTime();
+
+	if (depth > 0)
+		nodes[stack[depth - 1]]->selftime += now - lastswitch;
+
+	lastswitch = now;
+}
+
+static char *MakeLabel(lua_State *L, lua_Debug *ar, INT32 kind, const void *id)
+{
+	char *label;
+	char *p;
+
+	switch (kind)
+	{
+		case LPROF_HOOK:
+			return Z_StrDup(va("hook:%s", (const char *)id));
+		case LPROF_HUDHOOK:
+			return Z_StrDup(va("hud:%s", (const char *)id));
+		case LPROF_MOBJTYPE:
+		{
+			mobjtype_t type = (mobjtype_t)(size_t)id;
+
+			if (type >= MT_FIRSTFREESLOT && type < NUMMOBJTYPES && FREE_MOBJS[type - MT_FIRSTFREESLOT])
+				return Z_StrDup(va("MT_%s", FREE_MOBJS[type - MT_FIRSTFREESLOT]));
+			else if (type < MT_FIRSTFREESLOT)
+				return Z_StrDup(MOBJTYPE_LIST[type]);
+			return Z_StrDup(va("mobjtype %d", type));
+		}
+		case LPROF_UNHOOKED:
+			return Z_StrDup("(unhooked)");
+		default:
+			break;
+	}
+
+	lua_getinfo(L, "Sn", ar);
+
+	if (ar->what[0] == 'C')
+		label = Z_StrDup(va("[C] %s", ar->name ? ar->name : "?"));
+	else if (ar->what[0] == 'm')
+		label = Z_StrDup(va("main (%s)", ar->short_src));
+	else
+		label = Z_StrDup(va("%s (%s:%d)", ar->name ? ar->name : "?", ar->short_src, ar->linedefined));
+
+	// ';' separates frames in the folded format
+	for (p = label; *p; p++)
+	{
+		if (*p == ';')
+			*p = ':';
+	}
+
+	return label;
+}
+
+static INT32 FindNode(lua_State *L, lua_Debug *ar, INT32 kind, const void *id)
+{
+	lprofkey_t key;
+	lprofnode_t *node;
+
+	memset(&key, 0, sizeof key);
+	key.parent = depth > 0 ? stack[depth - 1] : -1;
+	key.kind = kind;
+	key.id = id;
+
+	HASH_FIND(hh, nodemap, &key, sizeof key, node);
+
+	if (node == NULL)
+	{
+		node = Z_Calloc(sizeof *node, PU_STATIC, NULL);
+		node->key = key;
+		node->index = numnodes;
+		node->parent = key.parent;
+		node->label = MakeLabel(L, ar, kind, id);
+
+		if (numnodes == maxnodes)
+		{
+			maxnodes = maxnodes ? maxnodes * 2 : 256;
+			nodes = Z_Realloc(nodes, maxnodes * sizeof *nodes, PU_STATIC, NULL);
+		}
+		nodes[numnodes++] = node;
+
+		HASH_ADD(hh, nodemap, key, sizeof key, node);
+	}
+
+	return node->index;
+}
+
+static void PushNode(INT32 index)
+{
+	if (overflow > 0 || depth == MAXPROFDEPTH)
+	{
+		overflow++;
+		return;
+	}
+
+	nodes[index]->calls++;
+	stack[depth++] = index;
+}
+
+static void PopNode(void)
+{
+	if (overflow > 0)
+		overflow--;
+	else if (depth > 0)
+		depth--;
+}
+
+static void PushFunction(lua_State *L, lua_Debug *ar)
+{
+	const void *func;
+
+	if (overflow > 0 || depth == MAXPROFDEPTH)
+	{
+		overflow++;
+		return;
+	}
+
+	lua_getinfo(L, "f", ar);
+	func = lua_topointer(L, -1);
+	lua_pop(L, 1);
+
+	PushNode(FindNode(L, ar, LPROF_FUNC, func));
+}
+
+// Coroutines that yield never return, which leaves stale frames behind.
+// The hook that resumed them cleans up in LUA_ProfileLeave.
+static void ProfileHook(lua_State *L, lua_Debug *ar)
+{
+	switch (ar->event)
+	{
+		case LUA_HOOKCALL:
+			ChargeTop();
+			if (depth == 0)
+				PushNode(FindNode(L, ar, LPROF_UNHOOKED, NULL));
+			PushFunction(L, ar);
+			break;
+		case LUA_HOOKRET:
+		case LUA_HOOKTAILRET:
+			ChargeTop();
+			PopNode();
+			if (depth == 1 && overflow == 0 && nodes[stack[0]]->key.kind == LPROF_UNHOOKED)
+				PopNode();
+			break;
+		default:
+			break;
+	}
+}
+
+INT32 LUA_ProfileEnter(lprofframe_t kind, const char *name, mobjtype_t type)
+{
+	const INT32 olddepth = depth + overflow;
+
+	if (!lua_profiling)
+		return -1;
+
+	ChargeTop();
+
+	if (kind == LPROF_MOBJTYPE)
+		PushNode(FindNode(NULL, NULL, kind, (const void *)(size_t)type));
+	else
+		PushNode(FindNode(NULL, NULL, kind, name));
+
+	return olddepth;
+}
+
+void LUA_ProfileLeave(INT32 olddepth)
+{
+	if (!lua_profiling || olddepth < 0)
+		return;
+
+	ChargeTop();
+
+	if (olddepth >= depth + overflow)
+		return;
+
+	if (olddepth > MAXPROFDEPTH)
+	{
+		depth = MAXPROFDEPTH;
+		overflow = olddepth - MAXPROFDEPTH;
+	}
+	else
+	{
+		depth = olddepth;
+		overflow = 0;
+	}
+}
+
+void LUA_ProfileReset(void)
+{
+	INT32 i;
+
+	HASH_CLEAR(hh, nodemap);
+
+	for (i = 0; i < numnodes; i++)
+	{
+		Z_Free(nodes[i]->label);
+		Z_Free(nodes[i]);
+	}
+
+	Z_Free(nodes);
+	nodes = NULL;
+	numnodes = maxnodes = 0;
+	depth = overflow = 0;
+}
+
+void LUA_ProfileStart(void)
+{
+	if (!gL || lua_profiling)
+		return;
+
+	lua_profiling = true;
+	depth = overflow = 0;
+	lastswitch = I_GetPreciseTime();
+	lua_sethook(gL, ProfileHook, LUA_MASKCALL|LUA_MASKRET, 0);
+}
+
+void LUA_ProfileStop(void)
+{
+	if (!lua_profiling)
+		return;
+
+	ChargeTop();
+	lua_profiling = false;
+	depth = overflow = 0;
+
+	if (gL)
+		lua_sethook(gL, NULL, 0, 0);
+}
+
+void LUA_ProfileStateClosed(void)
+{
+	// Function identities are pointers into the old state
+	lua_profiling = false;
+	LUA_ProfileReset();
+}
+
+static UINT64 ToMicroseconds(precise_t t)
+{
+	return (UINT64)t * 1000000 / I_GetPrecisePrecision();
+}
+
+static void WriteStack(FILE *f, INT32 index)
+{
+	if (nodes[index]->parent >= 0)
+	{
+		WriteStack(f, nodes[index]->parent);
+		fputc(';', f);
+	}
+
+	fputs(nodes[index]->label, f);
+}
+
+boolean LUA_ProfileDump(const char *filename)
+{
+	FILE *f = fopen(filename, "w");
+	INT32 i;
+
+	if (!f)
+		return false;
+
+	for (i = 0; i < numnodes; i++)
+	{
+		UINT64 us = ToMicroseconds(nodes[i]->selftime);
+
+		if (us == 0)
+			continue;
+
+		WriteStack(f, i);
+		fprintf(f, " %s\n", sizeu1((size_t)us));
+	}
+
+	fclose(f);
+	return true;
+}
+
+static int CompareSelfTime(const void *a, const void *b)
+{
+	const lprofnode_t *na = *(const lprofnode_t * const *)a;
+	const lprofnode_t *nb = *(const lprofnode_t * const *)b;
+
+	if (na->selftime != nb->selftime)
+		return na->selftime < nb->selftime ? 1 : -1;
+	return 0;
+}
+
+static void PrintTop(INT32 count)
+{
+	lprofnode_t **sorted;
+	INT32 i;
+
+	if (numnodes == 0)
+	{
+		CONS_Printf("No profiling data.\n");
+		return;
+	}
+
+	sorted = Z_Malloc(numnodes * sizeof *sorted, PU_STATIC, NULL);
+	memcpy(sorted, nodes, numnodes * sizeof *sorted);
+	qsort(sorted, numnodes, sizeof *sorted, CompareSelfTime);
+
+	if (count > numnodes)
+		count = numnodes;
+
+	CONS_Printf("%10s %8s  %s\n", "self (us)", "calls", "function <- caller");
+
+	for (i = 0; i < count; i++)
+	{
+		const lprofnode_t *node = sorted[i];
+
+		CONS_Printf("%10s %8u  %s <- %s\n",
+			sizeu1((size_t)ToMicroseconds(node->selftime)), node->calls, node->label,
+			node->parent >= 0 ? nodes[node->parent]->label : "(root)");
+	}
+
+	Z_Free(sorted);
+}
+
+void Command_LuaProfile_f(void)
+{
+	const char *cmd = COM_Argv(1);
+
+	if (COM_Argc() < 2)
+	{
+		CONS_Printf(
+			"luaprofile start: start profiling Lua\n"
+			"luaprofile stop: stop profiling Lua\n"
+			"luaprofile reset: throw away collected data\n"
+			"luaprofile top [count]: list the functions with the most self time\n"
+			"luaprofile dump [file]: write folded stacks for flamegraph.pl\n");
+		return;
+	}
+
+	if (!stricmp(cmd, "start"))
+	{
+		if (!gL)
+			CONS_Printf("No Lua state to profile.\n");
+		else
+		{
+			LUA_ProfileStart();
+			CONS_Printf("Lua profiling started.\n");
+		}
+	}
+	else if (!stricmp(cmd, "stop"))
+	{
+		LUA_ProfileStop();
+		CONS_Printf("Lua profiling stopped.\n");
+	}
+	else if (!stricmp(cmd, "reset"))
+		LUA_ProfileReset();
+	else if (!stricmp(cmd, "top"))
+		PrintTop(COM_Argc() > 2 ? atoi(COM_Argv(2)) : 20);
+	else if (!stricmp(cmd, "dump"))
+	{
+		const char *name = COM_Argc() > 2 ? COM_Argv(2) : "luaprofile.txt";
+		char *path = va(pandf, srb2home, name);
+
+		if (LUA_ProfileDump(path))
+			CONS_Printf("Wrote %s\n", path);
+		else
+			CONS_Alert(CONS_ERROR, "Couldn't write %s\n", path);
+	}
+	else
+		CONS_Printf("Unknown luaprofile command %s\n", cmd);
+}
@@ -0,0 +1,51 @@
+// SONIC ROBO BLAST 2
+//-----------------------------------------------------------------------------
+// Copyright (C) 2024 by Sonic Team Junior.
+//
+// This program is free software distributed under the
+// terms of the GNU General Public License, version 2.
+// See the 'LICENSE' file for more details.
+//-----------------------------------------------------------------------------
+/// \file  lua_profile.h
+/// \brief Per-hook and per-function Lua profiler
+
+#ifndef __LUA_PROFILE_H__
+#define __LUA_PROFILE_H__
+
+#include "doomtype.h"
+#include "info.h"
+
+// Kinds of synthetic frames pushed by the hook dispatcher
+typedef enum
+{
+	LPROF_HOOK,     // generic hook, label is the hook name
+	LPROF_HUDHOOK,  // HUD hook, label is the HUD hook name
+	LPROF_MOBJTYPE, // mobj hook for a specific mobj type
+} lprofframe_t;
+
+extern boolean lua_profiling;
+
+void LUA_ProfileStart(void);
+void LUA_ProfileStop(void);
+void LUA_ProfileReset(void);
+
+// Must be called whenever the Lua state is closed
+void LUA_ProfileStateClosed(void);
+
+// Brackets a hook call, so everything in between is attributed to it.
+// Returns the depth to pass to LUA_ProfileLeave.
+INT32 LUA_ProfileEnter(lprofframe_t kind, const char *name, mobjtype_t type);
+void LUA_ProfileLeave(INT32 depth);
+
+// Cheap checks for the hook dispatcher, when profiling is off
+#define LUA_PROFILE_ENTER(kind, name, type) \
+	(lua_profiling ? LUA_ProfileEnter((kind), (name), (type)) : -1)
+#define LUA_PROFILE_LEAVE(depth) \
+	do { if ((depth) >= 0) LUA_ProfileLeave(depth); } while (0)
+
+// Writes flamegraph-compatible folded stacks, weighted in microseconds
+boolean LUA_ProfileDump(const char *filename);
+
+void Command_LuaProfile_f(void);
+
+#endif
@@ -27,6 +27,11 @@
 #include "p_local.h"
 #include "p_slopes.h" // for P_SlopeById and slopelist
 #include "p_polyobj.h" // polyobj_t, PolyObjects
+#include "i_system.h" // I_GetPreciseTime, I_mkdir
+#include "netcode/d_netcmd.h" // cv_luagc_*, cv_luacache
+#include "d_main.h" // srb2home
+#include "m_misc.h" // FIL_ReadFile
+#include "md5.h"
 #ifdef LUA_ALLOW_BYTECODE
 #include "netcode/d_netfil.h" // for LUA_DumpFile
 #endif
@@ -34,6 +39,7 @@
 #include "lua_script.h"
 #include "lua_libs.h"
 #include "lua_hook.h"
+#include "lua_profile.h"
 
 #include "doomstat.h"
 #include "g_state.h"
@@ -66,8 +72,121 @@ static lua_CFunction liblist[] = {
 	NULL
 };
 
+// Small allocations (strings, tables, closures...) are served from
+// size-class slabs, so they don't pay for a zone block header and list
+// insertion each. Lua always tells us the old size of a block, so the
+// arena doesn't need headers of its own.
+#define ARENA_GRANULE 16
+#define ARENA_CLASSES 16
+#define ARENA_MAXSIZE (ARENA_GRANULE * ARENA_CLASSES)
+#define ARENA_SLABSIZE (64 * 1024)
+
+#define ARENA_CLASS(size) (((size) - 1) / ARENA_GRANULE)
+
+typedef struct arenablock_s
+{
+	struct arenablock_s *next;
+} arenablock_t;
+
+static arenablock_t *arenafree[ARENA_CLASSES];
+static arenablock_t *arenaslabs; // first granule of every slab links them
+
+static void *LUA_ArenaAlloc(size_t size)
+{
+	const size_t sizeclass = ARENA_CLASS(size);
+	arenablock_t *block = arenafree[sizeclass];
+
+	if (block == NULL)
+	{
+		const size_t blocksize = (sizeclass + 1) * ARENA_GRANULE;
+		UINT8 *slab = Z_Malloc(ARENA_SLABSIZE, PU_LUA, NULL);
+		UINT8 *p;
+
+		((arenablock_t *)slab)->next = arenaslabs;
+		arenaslabs = (arenablock_t *)slab;
+
+		for (p = slab + ARENA_GRANULE; p + blocksize <= slab + ARENA_SLABSIZE; p += blocksize)
+		{
+			block = (arenablock_t *)p;
+			block->next = arenafree[sizeclass];
+			arenafree[sizeclass] = block;
+		}
+
+		block = arenafree[sizeclass];
+	}
+
+	arenafree[sizeclass] = block->next;
+	return block;
+}
+
+static void LUA_ArenaFree(void *ptr, size_t size)
+{
+	arenablock_t *block = ptr;
+	const size_t sizeclass = ARENA_CLASS(size);
+
+	block->next = arenafree[sizeclass];
+	arenafree[sizeclass] = block;
+}
+
+// Releases every slab. Only valid once gL is closed, which is the only
+// state allocating from the arena.
+static void LUA_ArenaClear(void)
+{
+	while (arenaslabs)
+	{
+		arenablock_t *next = arenaslabs->next;
+		Z_Free(arenaslabs);
+		arenaslabs = next;
+	}
+
+	memset(arenafree, 0, sizeof arenafree);
+}
+
 // Lua asks for memory using this.
 static void *LUA_Alloc(void *ud, void *ptr, size_t osize, size_t nsize)
+{
+	void *newptr;
+
+	(void)ud;
+
+	if (nsize == 0)
+	{
+		if (osize > ARENA_MAXSIZE)
+			Z_Free(ptr);
+		else if (osize != 0)
+			LUA_ArenaFree(ptr, osize);
+		return NULL;
+	}
+
+	if (osize > ARENA_MAXSIZE && nsize > ARENA_MAXSIZE)
+		return Z_Realloc(ptr, nsize, PU_LUA, NULL);
+
+	if (osize != 0 && osize <= ARENA_MAXSIZE && nsize <= ARENA_MAXSIZE
+		&& ARENA_CLASS(osize) == ARENA_CLASS(nsize))
+		return ptr;
+
+	// moving between size classes, or between the arena and the zone
+	if (nsize > ARENA_MAXSIZE)
+		newptr = Z_Malloc(nsize, PU_LUA, NULL);
+	else
+		newptr = LUA_ArenaAlloc(nsize);
+
+	if (osize != 0)
+	{
+		M_Memcpy(newptr, ptr, min(osize, nsize));
+
+		if (osize > ARENA_MAXSIZE)
+			Z_Free(ptr);
+		else
+			LUA_ArenaFree(ptr, osize);
+	}
+
+	return newptr;
+}
+
+// Allocator for Lua states other than gL. These must not use the arena,
+// since it is released whenever gL is closed.
+static void *LUA_ZoneAlloc(void *ud, void *ptr, size_t osize, size_t nsize)
 {
 	(void)ud;
 	if (nsize == 0) {
@@ -550,6 +669,9 @@ static int setglobals(lua_State *L)
 	return luaL_error(L, "Implicit global " LUA_QS " prevented. Create a local variable instead.", csname);
 }
 
+// LREG_VALID, as an integer registry reference
+static int validref = LUA_NOREF;
+
 // Clear and create a new Lua state, laddo!
 // There's SCRIPTIN to be had!
 static void LUA_ClearState(void)
@@ -559,7 +681,11 @@ static void LUA_ClearState(void)
 
 	// close previous state
 	if (gL)
+	{
+		LUA_ProfileStateClosed();
 		lua_close(gL);
+		LUA_ArenaClear();
+	}
 	gL = NULL;
 
 	CONS_Printf(M_GetText("Pardon me while I initialize the Lua scripting interface...\n"));
@@ -573,7 +699,10 @@ static void LUA_ClearState(void)
 	lua_settop(L, 0);
 
 	// make LREG_VALID table for all pushed userdata cache.
+	// Also keep an integer reference to it, since it is fetched on every push.
 	lua_newtable(L);
+	lua_pushvalue(L, -1);
+	validref = luaL_ref(L, LUA_REGISTRYINDEX);
 	lua_setfield(L, LUA_REGISTRYINDEX, LREG_VALID);
 
 	// make LREG_METATABLES table for all registered metatables
@@ -595,6 +724,7 @@ static void LUA_ClearState(void)
 
 	// lua state is ready!
 	gL = L;
+	LUA_SetGCParams();
 }
 
 #ifdef _DEBUG
@@ -612,11 +742,187 @@ void LUA_ClearExtVars(void)
 // (i.e. they were called in hooks or coroutines etc)
 INT32 lua_lumploading = 0;
 
+#ifndef NOMD5
+// Scripts compiled once are kept in srb2home/luacache, named after the
+// MD5 of their source and chunk name. The header ties an entry to the
+// exact build that wrote it, and the payload is checksummed, so a stale
+// or damaged entry is simply recompiled.
+#define LUACACHE_MAGIC "SRB2LUAC"
+#define LUACACHE_MAGICLEN 8
+#define LUACACHE_VERSIONLEN 64
+#define LUACACHE_HEADERSIZE (LUACACHE_MAGICLEN + LUACACHE_VERSIONLEN + 16 + 4 + 16)
+
+typedef struct
+{
+	UINT8 *data;
+	size_t size;
+	size_t capacity;
+} luacachebuf_t;
+
+static const char *LUA_CacheBuildVersion(void)
+{
+	static char version[LUACACHE_VERSIONLEN];
+
+	if (!version[0])
+		snprintf(version, sizeof version, "%s %s %s", VERSIONSTRING, comprevision, compdate);
+
+	return version;
+}
+
+static const char *LUA_CachePath(const UINT8 *key)
+{
+	return va("%s" PATHSEP "luacache" PATHSEP
+		"%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x.luac", srb2home,
+		key[0], key[1], key[2], key[3], key[4], key[5], key[6], key[7],
+		key[8], key[9], key[10], key[11], key[12], key[13], key[14], key[15]);
+}
+
+static void LUA_CacheKey(MYFILE *f, const char *chunkname, UINT8 *key)
+{
+	char keysrc[16 + MAX_WADPATH + 64];
+	size_t namelen = min(strlen(chunkname), sizeof keysrc - 16);
+
+	// MD5 of the source, followed by the chunk name
+	md5_buffer(f->data, f->size, keysrc);
+	M_Memcpy(keysrc + 16, chunkname, namelen);
+	md5_buffer(keysrc, 16 + namelen, key);
+}
+
+static const char *CacheReader(lua_State *L, void *ud, size_t *size)
+{
+	luacachebuf_t *buf = ud;
+	(void)L;
+
+	if (buf->size == 0)
+		return NULL;
+
+	*size = buf->size;
+	buf->size = 0;
+	return (const char *)buf->data;
+}
+
+// Pushes the compiled chunk and returns true if the cache had a valid one
+static boolean LUA_LoadFromCache(const UINT8 *key, const char *chunkname)
+{
+	const char *path = LUA_CachePath(key);
+	UINT8 *file = NULL;
+	size_t length = FIL_ReadFile(path, &file);
+	char version[LUACACHE_VERSIONLEN];
+	UINT8 checksum[16];
+	UINT8 *p = file;
+	luacachebuf_t payload;
+	boolean valid = false;
+
+	if (length < LUACACHE_HEADERSIZE)
+	{
+		if (file)
+			Z_Free(file);
+		return false;
+	}
+
+	memset(version, 0, sizeof version);
+	strlcpy(version, LUA_CacheBuildVersion(), LUACACHE_VERSIONLEN);
+
+	if (!memcmp(p, LUACACHE_MAGIC, LUACACHE_MAGICLEN)
+		&& !memcmp(p + LUACACHE_MAGICLEN, version, LUACACHE_VERSIONLEN)
+		&& !memcmp(p + LUACACHE_MAGICLEN + LUACACHE_VERSIONLEN, key, 16))
+	{
+		p += LUACACHE_MAGICLEN + LUACACHE_VERSIONLEN + 16;
+		payload.size = READUINT32(p);
+		payload.data = p + 16;
+
+		if (payload.size == length - LUACACHE_HEADERSIZE)
+		{
+			md5_buffer((const char *)payload.data, payload.size, checksum);
+			valid = !memcmp(p, checksum, 16);
+		}
+	}
+
+	if (valid && lua_loadtrusted(gL, CacheReader, &payload, chunkname))
+	{
+		CONS_Debug(DBG_LUA, "Bad Lua cache entry %s: %s\n", path, lua_tostring(gL, -1));
+		lua_pop(gL, 1);
+		valid = false;
+	}
+
+	Z_Free(file);
+
+	if (!valid)
+		remove(path);
+
+	return valid;
+}
+
+static int CacheWriter(lua_State *L, const void *p, size_t sz, void *ud)
+{
+	luacachebuf_t *buf = ud;
+	(void)L;
+
+	if (buf->size + sz > buf->capacity)
+	{
+		buf->capacity = max(buf->capacity * 2, buf->size + sz);
+		buf->data = Z_Realloc(buf->data, buf->capacity, PU_STATIC, NULL);
+	}
+
+	M_Memcpy(buf->data + buf->size, p, sz);
+	buf->size += sz;
+	return 0;
+}
+
+// Stores the chunk on top of the stack
+static void LUA_StoreInCache(const UINT8 *key)
+{
+	const char *path;
+	char tmppath[256+16];
+	luacachebuf_t buf;
+	UINT8 *p;
+
+	buf.capacity = 4096;
+	buf.size = LUACACHE_HEADERSIZE;
+	buf.data = Z_Calloc(buf.capacity, PU_STATIC, NULL);
+
+	if (lua_dump(gL, CacheWriter, &buf) != 0)
+	{
+		Z_Free(buf.data);
+		return;
+	}
+
+	p = buf.data;
+	M_Memcpy(p, LUACACHE_MAGIC, LUACACHE_MAGICLEN);
+	p += LUACACHE_MAGICLEN;
+	strlcpy((char *)p, LUA_CacheBuildVersion(), LUACACHE_VERSIONLEN);
+	p += LUACACHE_VERSIONLEN;
+	M_Memcpy(p, key, 16);
+	p += 16;
+	WRITEUINT32(p, (UINT32)(buf.size - LUACACHE_HEADERSIZE));
+	md5_buffer((const char *)buf.data + LUACACHE_HEADERSIZE, buf.size - LUACACHE_HEADERSIZE, p);
+
+	I_mkdir(va("%s" PATHSEP "luacache", srb2home), 0755);
+
+	// write under a temporary name, so a crash can't leave half an entry
+	path = LUA_CachePath(key);
+	snprintf(tmppath, sizeof tmppath, "%s.tmp", path);
+
+	if (FIL_WriteFile(tmppath, buf.data, buf.size))
+	{
+		remove(path);
+		if (rename(tmppath, path) != 0)
+			remove(tmppath);
+	}
+
+	Z_Free(buf.data);
+}
+#endif
+
 // Load a script from a MYFILE
 static inline boolean LUA_LoadFile(MYFILE *f, char *name)
 {
 	int errorhandlerindex;
 	boolean success;
+	char *chunkname;
+#ifndef NOMD5
+	UINT8 key[16];
+#endif
 
 	if (!name)
 		name = wadfiles[f->wad]->filename;
@@ -629,12 +935,34 @@ static inline boolean LUA_LoadFile(MYFILE *f, char *name)
 	lua_pushcfunction(gL, LUA_GetErrorMessage);
 	errorhandlerindex = lua_gettop(gL);
 
-	success = !luaL_loadbuffer(gL, f->data, f->size, va("@%s",name));
+	chunkname = Z_StrDup(va("@%s",name));
+
+#ifndef NOMD5
+	if (cv_luacache.value)
+	{
+		LUA_CacheKey(f, chunkname, key);
+
+		if (LUA_LoadFromCache(key, chunkname))
+		{
+			Z_Free(chunkname);
+			lua_remove(gL, errorhandlerindex);
+			return true;
+		}
+	}
+#endif
+
+	success = !luaL_loadbuffer(gL, f->data, f->size, chunkname);
 
 	if (!success) {
 		CONS_Alert(CONS_WARNING,"%s\n",lua_tostring(gL,-1));
 		lua_pop(gL,1);
 	}
+#ifndef NOMD5
+	else if (cv_luacache.value)
+		LUA_StoreInCache(key);
+#endif
+
+	Z_Free(chunkname);
 
 	lua_gc(gL, LUA_GCCOLLECT, 0);
 	lua_remove(gL, errorhandlerindex);
@@ -800,8 +1128,8 @@ fixed_t LUA_EvalMath(const char *word)
 	if (!L)
 	{
 		// make a new state so SOC can't interefere with scripts
-		// allocate state
-		L = lua_newstate(LUA_Alloc, NULL);
+		// allocate state, outside of the arena since it outlives gL
+		L = lua_newstate(LUA_ZoneAlloc, NULL);
 		lua_atpanic(L, LUA_Panic);
 
 		// open only enum lib
@@ -860,7 +1188,7 @@ lpushed_t LUA_RawPushUserdata(lua_State *L, void *data)
 		return status;
 	}
 
-	lua_getfield(L, LUA_REGISTRYINDEX, LREG_VALID);
+	lua_rawgeti(L, LUA_REGISTRYINDEX, validref);
 	I_Assert(lua_istable(L, -1));
 
 	lua_pushlightuserdata(L, data);
@@ -898,7 +1226,7 @@ void LUA_InvalidateUserdata(void *data)
 		return;
 
 	// fetch the userdata
-	lua_getfield(gL, LUA_REGISTRYINDEX, LREG_VALID);
+	lua_rawgeti(gL, LUA_REGISTRYINDEX, validref);
 	I_Assert(lua_istable(gL, -1));
 		lua_pushlightuserdata(gL, data);
 		lua_rawget(gL, -2);
@@ -1025,8 +1353,8 @@ enum
 	ARCH_INT8,
 	ARCH_INT16,
 	ARCH_INT32,
-	ARCH_SMALLSTRING,
-	ARCH_LARGESTRING,
+	ARCH_STRING,
+	ARCH_STRINGREF,
 	ARCH_TABLE,
 
 	ARCH_MOBJINFO,
@@ -1082,6 +1410,57 @@ static const struct {
 	{NULL,          ARCH_NULL}
 };
 
+// Lookups that live for the duration of one (un)archive, as registry references.
+// Strings are written in full the first time only, and referred to by
+// their index afterwards. Tables are mapped back to their ids, so
+// finding whether a table was already archived doesn't need a search.
+static int archstrings = LUA_NOREF; // string -> index when archiving, index -> string when unarchiving
+static int archtableids = LUA_NOREF; // table -> id, when archiving
+static UINT32 numarchstrings;
+
+static void OpenArchiveLookups(void)
+{
+	lua_newtable(gL);
+	archstrings = luaL_ref(gL, LUA_REGISTRYINDEX);
+	lua_newtable(gL);
+	archtableids = luaL_ref(gL, LUA_REGISTRYINDEX);
+	numarchstrings = 0;
+}
+
+static void CloseArchiveLookups(void)
+{
+	luaL_unref(gL, LUA_REGISTRYINDEX, archstrings);
+	luaL_unref(gL, LUA_REGISTRYINDEX, archtableids);
+	archstrings = archtableids = LUA_NOREF;
+}
+
+// Unsigned integers, 7 bits per byte, high bit set if more bytes follow
+static void WriteVarint(UINT32 n)
+{
+	while (n >= 0x80)
+	{
+		WRITEUINT8(save_p, (UINT8)(n | 0x80));
+		n >>= 7;
+	}
+	WRITEUINT8(save_p, (UINT8)n);
+}
+
+static UINT32 ReadVarint(void)
+{
+	UINT32 n = 0;
+	UINT8 shift = 0;
+	UINT8 byte;
+
+	do
+	{
+		byte = READUINT8(save_p);
+		n |= (UINT32)(byte & 0x7F) << shift;
+		shift += 7;
+	} while ((byte & 0x80) && shift < 32);
+
+	return n;
+}
+
 static UINT8 GetUserdataArchType(int index)
 {
 	UINT8 i;
@@ -1106,6 +1485,8 @@ static UINT8 ArchiveValue(int TABLESINDEX, int myindex)
 {
 	if (myindex < 0)
 		myindex = lua_gettop(gL)+1+myindex;
+	if (P_SaveBufferFull(0))
+		return 0;
 	switch (lua_type(gL, myindex))
 	{
 	case LUA_TNONE:
@@ -1143,60 +1524,71 @@ static UINT8 ArchiveValue(int TABLESINDEX, int myindex)
 	}
 	case LUA_TSTRING:
 	{
-		UINT32 len = (UINT32)lua_objlen(gL, myindex); // get length of string, including embedded zeros
-		const char *s = lua_tostring(gL, myindex);
-		UINT32 i = 0;
-		// if you're wondering why we're writing a string to save_p this way,
-		// it turns out that Lua can have embedded zeros ('\0') in the strings,
-		// so we can't use WRITESTRING as that cuts off when it finds a '\0'.
-		// Saving the size of the string also allows us to get the size of the string on the other end,
-		// fixing the awful crashes previously encountered for reading strings longer than 1024
-		// (yes I know that's kind of a stupid thing to care about, but it'd be evil to trim or ignore them?)
-		// -- Monster Iestyn 05/08/18
-		if (len < 255)
-		{
-			WRITEUINT8(save_p, ARCH_SMALLSTRING);
-			WRITEUINT8(save_p, len); // save size of string
-		}
-		else
+		size_t len;
+		const char *s;
+
+		lua_rawgeti(gL, LUA_REGISTRYINDEX, archstrings);
+		lua_pushvalue(gL, myindex);
+		lua_rawget(gL, -2);
+
+		if (lua_isnumber(gL, -1)) // already written once
 		{
-			WRITEUINT8(save_p, ARCH_LARGESTRING);
-			WRITEUINT32(save_p, len); // save size of string
+			WRITEUINT8(save_p, ARCH_STRINGREF);
+			WriteVarint((UINT32)lua_tointeger(gL, -1));
+			lua_pop(gL, 2);
+			break;
 		}
-		while (i < len)
-			WRITECHAR(save_p, s[i++]); // write chars individually, including the embedded zeros
+
+		lua_pop(gL, 1);
+		lua_pushvalue(gL, myindex);
+		lua_pushinteger(gL, ++numarchstrings);
+		lua_rawset(gL, -3);
+		lua_pop(gL, 1);
+
+		// Lua strings can have embedded zeros ('\0'), so they can't be
+		// written with WRITESTRING; the length is saved before the
+		// characters instead.
+		s = lua_tolstring(gL, myindex, &len);
+		if (P_SaveBufferFull(len))
+			break;
+		WRITEUINT8(save_p, ARCH_STRING);
+		WriteVarint((UINT32)len);
+		WRITEMEM(save_p, s, len);
 		break;
 	}
 	case LUA_TTABLE:
 	{
-		boolean found = false;
-		INT32 i;
-		UINT16 t = (UINT16)lua_objlen(gL, TABLESINDEX);
+		boolean found;
+		UINT16 t;
 
-		for (i = 1; i <= t && !found; i++)
-		{
-			lua_rawgeti(gL, TABLESINDEX, i);
-			if (lua_rawequal(gL, myindex, -1))
-			{
-				t = i;
-				found = true;
-			}
-			lua_pop(gL, 1);
-		}
-		if (!found)
+		lua_rawgeti(gL, LUA_REGISTRYINDEX, archtableids);
+		lua_pushvalue(gL, myindex);
+		lua_rawget(gL, -2);
+		found = lua_isnumber(gL, -1);
+
+		if (found)
+			t = (UINT16)lua_tointeger(gL, -1);
+		else
 		{
-			t++;
+			t = (UINT16)lua_objlen(gL, TABLESINDEX) + 1;
 
 			if (t == 0)
 			{
 				CONS_Alert(CONS_ERROR, "Too many tables to archive!\n");
 				WRITEUINT8(save_p, ARCH_NULL);
+				lua_pop(gL, 2);
 				return 0;
 			}
+
+			lua_pushvalue(gL, myindex);
+			lua_pushinteger(gL, t);
+			lua_rawset(gL, -4);
 		}
 
+		lua_pop(gL, 2); // pop the id and the table ids
+
 		WRITEUINT8(save_p, ARCH_TABLE);
-		WRITEUINT16(save_p, t);
+		WriteVarint(t);
 
 		if (!found)
 		{
@@ -1421,6 +1813,9 @@ static void ArchiveExtVars(void *pointer, const char *ptype)
 	int TABLESINDEX;
 	UINT16 i;
 
+	if (P_SaveBufferFull(0))
+		return;
+
 	if (!gL) {
 		if (fastcmp(ptype,"player")) // players must always be included, even if no vars
 			WRITEUINT16(save_p, 0);
@@ -1463,7 +1858,7 @@ static void ArchiveExtVars(void *pointer, const char *ptype)
 	while (lua_next(gL, -2))
 	{
 		I_Assert(lua_type(gL, -2) == LUA_TSTRING);
-		WRITESTRING(save_p, lua_tostring(gL, -2));
+		ArchiveValue(TABLESINDEX, -2); // field names repeat a lot, so they get interned
 		if (ArchiveValue(TABLESINDEX, -1) == 2)
 			CONS_Alert(CONS_ERROR, "Type of value for %s entry '%s' (%s) could not be archived!\n", ptype, lua_tostring(gL, -2), luaL_typename(gL, -1));
 		lua_pop(gL, 1);
@@ -1485,6 +1880,7 @@ static void ArchiveTables(void)
 {
 	int TABLESINDEX;
 	UINT16 i, n;
+	UINT32 j, len;
 	UINT8 e;
 
 	if (!gL)
@@ -1493,12 +1889,38 @@ static void ArchiveTables(void)
 	TABLESINDEX = lua_gettop(gL);
 
 	n = (UINT16)lua_objlen(gL, TABLESINDEX);
-	for (i = 1; i <= n; i++)
+	for (i = 1; i <= n && !P_SaveBufferFull(0); i++)
 	{
 		lua_rawgeti(gL, TABLESINDEX, i);
+
+		// The array part is written first, as values only
+		len = (UINT32)lua_objlen(gL, -1);
+		WriteVarint(len);
+		for (j = 1; j <= len; j++)
+		{
+			lua_rawgeti(gL, -1, j);
+			e = ArchiveValue(TABLESINDEX, -1);
+			if (e == 1)
+				n++;
+			else if (e == 2)
+				CONS_Alert(CONS_ERROR, "Type of value for table %d entry %u (%s) could not be archived!\n", i, j, luaL_typename(gL, -1));
+			lua_pop(gL, 1);
+		}
+
+		// Then everything else, as key and value pairs
 		lua_pushnil(gL);
 		while (lua_next(gL, -2))
 		{
+			if (lua_type(gL, -2) == LUA_TNUMBER)
+			{
+				lua_Integer k = lua_tointeger(gL, -2);
+				if (k >= 1 && (UINT32)k <= len)
+				{
+					lua_pop(gL, 1);
+					continue;
+				}
+			}
+
 			// Write key
 			e = ArchiveValue(TABLESINDEX, -2); // key should be either a number or a string, ArchiveValue can handle this.
 			if (e == 1)
@@ -1557,32 +1979,27 @@ static UINT8 UnArchiveValue(int TABLESINDEX)
 	case ARCH_INT32:
 		lua_pushinteger(gL, READFIXED(save_p));
 		break;
-	case ARCH_SMALLSTRING:
-	case ARCH_LARGESTRING:
+	case ARCH_STRING:
 	{
-		UINT32 len;
-		char *value;
-		UINT32 i = 0;
-
-		// See my comments in the ArchiveValue function;
-		// it's much the same for reading strings as writing them!
-		// (i.e. we can't use READSTRING either)
-		// -- Monster Iestyn 05/08/18
-		if (type == ARCH_SMALLSTRING)
-			len = READUINT8(save_p); // length of string, including embedded zeros
-		else
-			len = READUINT32(save_p); // length of string, including embedded zeros
-		value = malloc(len); // make temp buffer of size len
-		// now read the actual string
-		while (i < len)
-			value[i++] = READCHAR(save_p); // read chars individually, including the embedded zeros
-		lua_pushlstring(gL, value, len); // push the string (note: this function supports embedded zeros)
-		free(value); // free the buffer
+		UINT32 len = ReadVarint(); // length of string, including embedded zeros
+
+		lua_pushlstring(gL, (const char *)save_p, len);
+		save_p += len;
+
+		lua_rawgeti(gL, LUA_REGISTRYINDEX, archstrings);
+		lua_pushvalue(gL, -2);
+		lua_rawseti(gL, -2, ++numarchstrings);
+		lua_pop(gL, 1);
 		break;
 	}
+	case ARCH_STRINGREF:
+		lua_rawgeti(gL, LUA_REGISTRYINDEX, archstrings);
+		lua_rawgeti(gL, -1, ReadVarint());
+		lua_remove(gL, -2);
+		break;
 	case ARCH_TABLE:
 	{
-		UINT16 tid = READUINT16(save_p);
+		UINT16 tid = (UINT16)ReadVarint();
 		lua_rawgeti(gL, TABLESINDEX, tid);
 		if (lua_isnil(gL, -1))
 		{
@@ -1670,7 +2087,6 @@ static void UnArchiveExtVars(void *pointer)
 	int TABLESINDEX;
 	UINT16 field_count = READUINT16(save_p);
 	UINT16 i;
-	char field[1024];
 
 	if (field_count == 0)
 		return;
@@ -1681,9 +2097,9 @@ static void UnArchiveExtVars(void *pointer)
 
 	for (i = 0; i < field_count; i++)
 	{
-		READSTRING(save_p, field);
+		UnArchiveValue(TABLESINDEX); // field name
 		UnArchiveValue(TABLESINDEX);
-		lua_setfield(gL, -2, field);
+		lua_rawset(gL, -3);
 	}
 
 	lua_getfield(gL, LUA_REGISTRYINDEX, LREG_EXTVARS);
@@ -1707,6 +2123,7 @@ static void UnArchiveTables(void)
 {
 	int TABLESINDEX;
 	UINT16 i, n;
+	UINT32 j, len;
 	UINT16 metatableid;
 
 	if (!gL)
@@ -1718,6 +2135,19 @@ static void UnArchiveTables(void)
 	for (i = 1; i <= n; i++)
 	{
 		lua_rawgeti(gL, TABLESINDEX, i);
+
+		len = ReadVarint(); // array part
+		for (j = 1; j <= len; j++)
+		{
+			if (UnArchiveValue(TABLESINDEX) == 2)
+				n++;
+
+			if (lua_isnil(gL, -1))
+				lua_pop(gL, 1);
+			else
+				lua_rawseti(gL, -2, j);
+		}
+
 		while (true)
 		{
 			UINT8 e = UnArchiveValue(TABLESINDEX); // read key
@@ -1762,13 +2192,57 @@ void LUA_Step(void)
 	lua_gc(gL, LUA_GCSTEP, 1);
 }
 
+// Memory in use, in KB, when the next idle collection cycle may start
+static int idlegc_threshold = 0;
+
+// Spends part of the time the main loop would otherwise sleep on
+// incremental collection steps, so the collector rarely has to run
+// from inside an allocation during a tic.
+void LUA_IdleStep(precise_t idletime)
+{
+	precise_t deadline;
+
+	if (!gL || cv_luagc_idle.value == 0)
+		return;
+
+	// Start cycles earlier than the allocation-driven collector would,
+	// but don't keep running back to back ones.
+	if (lua_gc(gL, LUA_GCCOUNT, 0) < idlegc_threshold)
+		return;
+
+	deadline = I_GetPreciseTime() + idletime * cv_luagc_idle.value / 100;
+
+	do
+	{
+		if (lua_gc(gL, LUA_GCSTEP, cv_luagc_stepsize.value))
+		{
+			// Halfway to where the pause would trigger the next cycle
+			const int live = lua_gc(gL, LUA_GCCOUNT, 0);
+			idlegc_threshold = live + live * (cv_luagc_pause.value - 100) / 200;
+			break;
+		}
+	} while (I_GetPreciseTime() < deadline);
+}
+
+void LUA_SetGCParams(void)
+{
+	if (!gL)
+		return;
+	lua_gc(gL, LUA_GCSETPAUSE, cv_luagc_pause.value);
+	lua_gc(gL, LUA_GCSETSTEPMUL, cv_luagc_stepmul.value);
+	idlegc_threshold = 0;
+}
+
 void LUA_Archive(void)
 {
 	INT32 i;
 	thinker_t *th;
 
 	if (gL)
+	{
+		OpenArchiveLookups();
 		lua_newtable(gL); // tables to be archived.
+	}
 
 	for (i = 0; i < MAXPLAYERS; i++)
 	{
@@ -1794,7 +2268,10 @@ void LUA_Archive(void)
 	ArchiveTables();
 
 	if (gL)
+	{
 		lua_pop(gL, 1); // pop tables
+		CloseArchiveLookups();
+	}
 }
 
 void LUA_UnArchive(void)
@@ -1804,7 +2281,10 @@ void LUA_UnArchive(void)
 	thinker_t *th;
 
 	if (gL)
+	{
+		OpenArchiveLookups();
 		lua_newtable(gL); // tables to be read
+	}
 
 	for (i = 0; i < MAXPLAYERS; i++)
 	{
@@ -1829,7 +2309,10 @@ void LUA_UnArchive(void)
 	UnArchiveTables();
 
 	if (gL)
+	{
 		lua_pop(gL, 1); // pop tables
+		CloseArchiveLookups();
+	}
 }
 
 // For mobj_t, player_t, etc. to take custom variables.
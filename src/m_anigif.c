@@ -20,7 +20,6 @@
 #include "i_video.h"
 #include "i_system.h" // I_GetPreciseTime
 #include "m_misc.h"
-#include "st_stuff.h" // st_palette
 #include "doomstat.h" // singletics
 
 #ifdef HWRENDER
@@ -49,8 +48,14 @@ static UINT8 gif_dynamicdelay = (UINT8)0; // and messing something up
 // Palette handling
 static boolean gif_localcolortable = false;
 static boolean gif_colorprofile = false;
-static RGBA_t *gif_headerpalette = NULL;
-static RGBA_t *gif_framepalette = NULL;
+static UINT8 gif_headerpalette[768];
+
+// Frames are encoded on the movie encoder thread, so everything they need
+// is fixed when the GIF is opened, and buffers come from malloc, not the zone
+static INT32 gif_width, gif_height;
+static boolean gif_rgb = false; // frames are 24-bit RGB (OpenGL), not palette indices
+static UINT8 *gif_curframe = NULL; // RGB frame converted to the palette
+static UINT8 *gif_prevframe = NULL; // last frame written, for GIF_optimizeregion
 
 static FILE *gif_out = NULL;
 static INT32 gif_frames = 0;
@@ -63,6 +68,53 @@ static UINT8 gif_writeover = 0;
 // OPTIMIZE gif output
 // ---
 
+//
+// GIF_firstdiff
+// returns the offset of the first byte that differs, or n if none do.
+// compares a word at a time, as long as the spans are equal.
+//
+static INT32 GIF_firstdiff(const UINT8 *a, const UINT8 *b, INT32 n)
+{
+	INT32 i = 0;
+	size_t wa, wb;
+
+	for (; i + (INT32)sizeof (size_t) <= n; i += sizeof (size_t))
+	{
+		memcpy(&wa, a + i, sizeof (size_t));
+		memcpy(&wb, b + i, sizeof (size_t));
+		if (wa != wb)
+			break;
+	}
+
+	while (i < n && a[i] == b[i])
+		++i;
+
+	return i;
+}
+
+//
+// GIF_lastdiff
+// returns the offset of the last byte that differs, or -1 if none do.
+//
+static INT32 GIF_lastdiff(const UINT8 *a, const UINT8 *b, INT32 n)
+{
+	INT32 i = n;
+	size_t wa, wb;
+
+	for (; i >= (INT32)sizeof (size_t); i -= sizeof (size_t))
+	{
+		memcpy(&wa, a + i - sizeof (size_t), sizeof (size_t));
+		memcpy(&wb, b + i - sizeof (size_t), sizeof (size_t));
+		if (wa != wb)
+			break;
+	}
+
+	while (i > 0 && a[i - 1] == b[i - 1])
+		--i;
+
+	return i - 1;
+}
+
 //
 // GIF_optimizecmprow
 // checks a row for modification, and if any is detected, what parts
@@ -73,60 +125,33 @@ static UINT8 gif_writeover = 0;
 static UINT8 GIF_optimizecmprow(const UINT8 *dst, const UINT8 *src, INT32 row,
 	INT32 *last, INT32 *left, INT32 *right)
 {
-	const UINT8 *dp = dst + (vid.width * row);
-	const UINT8 *sp = src + (vid.width * row);
-	const UINT8 *dtmp, *stmp;
-	UINT8 doleft = 1, doright = 1;
-	INT32 i = 0;
+	const UINT8 *dp = dst + (gif_width * row);
+	const UINT8 *sp = src + (gif_width * row);
+	INT32 i;
 
-	if (!memcmp(sp, dp, vid.width))
+	if (!memcmp(sp, dp, gif_width))
 		return 0; // unchanged.
 
 	*last = row;
 
-	// left side
-	i = 0;
-	if (*left == 0) // edge reached
-		doleft = 0;
-	else if (*left > 0) // left set, nonzero
-	{
-		if (!memcmp(sp, dp, *left))
-			doleft = 0; // left side not changed
-	}
-	while (doleft)
+	// left side, only what is left of the known leftmost change
+	if (*left != 0) // edge not reached
 	{
-		dtmp = dp + i;
-		stmp = sp + i;
-		if (*dtmp != *stmp)
-		{
-			doleft = 0;
+		const INT32 span = (*left > 0) ? *left : gif_width;
+		i = GIF_firstdiff(dp, sp, span);
+		if (i < span)
 			*left = i;
-		}
-		++i;
 	}
 
-	// right side
-	i = vid.width - 1;
-	if (*right == vid.width - 1) // edge reached
-		doright = 0;
-	else if (*right >= 0) // right set, non-end-of-width
+	// right side, only what is right of the known rightmost change
+	if (*right != gif_width - 1) // edge not reached
 	{
-		dtmp = dp + *right + 1;
-		stmp = sp + *right + 1;
-		if (!memcmp(stmp, dtmp, vid.width - (*right + 1)))
-			doright = 0; // right side not changed
-	}
-	while (doright)
-	{
-		dtmp = dp + i;
-		stmp = sp + i;
-		if (*dtmp != *stmp)
-		{
-			doright = 0;
-			*right = i;
-		}
-		--i;
+		const INT32 start = (*right >= 0) ? *right + 1 : 0;
+		i = GIF_lastdiff(dp + start, sp + start, gif_width - start);
+		if (i >= 0)
+			*right = start + i;
 	}
+
 	return 1;
 }
 
@@ -143,7 +168,7 @@ static UINT8 GIF_optimizecmprow(const UINT8 *dst, const UINT8 *src, INT32 row,
 static void GIF_optimizeregion(const UINT8 *dst, const UINT8 *src,
 	INT32 *x, INT32 *y, INT32 *w, INT32 *h)
 {
-	INT32 st = 0, sb = vid.height - 1; // work from both directions
+	INT32 st = 0, sb = gif_height - 1; // work from both directions
 	INT32 firstchg_t = -1, firstchg_b = -1; // store first changed row.
 	INT32 lastchg_t = -1, lastchg_b = -1; // Store last row... just in case
 	INT32 lmpix = -1, rmpix = -1; // store left and rightmost change
@@ -154,7 +179,7 @@ static void GIF_optimizeregion(const UINT8 *dst, const UINT8 *src,
 		if (!stopt)
 		{
 			if (GIF_optimizecmprow(dst, src, st++, &lastchg_t, &lmpix, &rmpix)
-			 && lmpix == 0 && rmpix == vid.width - 1)
+			 && lmpix == 0 && rmpix == gif_width - 1)
 				stopt = 1;
 			if (firstchg_t < 0 && lastchg_t >= 0)
 				firstchg_t = lastchg_t;
@@ -162,7 +187,7 @@ static void GIF_optimizeregion(const UINT8 *dst, const UINT8 *src,
 		if (!stopb)
 		{
 			if (GIF_optimizecmprow(dst, src, sb--, &lastchg_b, &lmpix, &rmpix)
-			 && lmpix == 0 && rmpix == vid.width - 1)
+			 && lmpix == 0 && rmpix == gif_width - 1)
 				stopb = 1;
 			if (firstchg_b < 0 && lastchg_b >= 0)
 				firstchg_b = lastchg_b;
@@ -196,7 +221,7 @@ static UINT8 *gifbwr_buf = NULL;
 static UINT8 *gifbwr_cur;
 static UINT8 gifbwr_bufsize = 0;
 
-static UINT32 gifbwr_bits_buf = 0;
+static UINT64 gifbwr_bits_buf = 0;
 static INT32 gifbwr_bits_num = 0;
 static UINT8 gifbwr_bits_min = 9;
 
@@ -206,29 +231,32 @@ static UINT8 gifbwr_bits_min = 9;
 //
 static void GIF_bwrflush(void)
 {
-	if (gifbwr_bits_num > 0) // will be between 1 and 7
+	while (gifbwr_bits_num > 0) // will be between 1 and 31
 	{
 		WRITEUINT8(gifbwr_cur, (UINT8)(gifbwr_bits_buf&0xFF));
+		gifbwr_bits_buf >>= 8;
+		gifbwr_bits_num -= 8;
 		++gifbwr_bufsize;
 	}
-	gifbwr_bits_buf = gifbwr_bits_num = 0;
+	gifbwr_bits_buf = 0;
+	gifbwr_bits_num = 0;
 }
 
 //
 // GIF_bwr_write
 // writes bits into bit buffer,
-// writes into buffer when whole bytes obtained
+// writes into buffer four bytes at a time
 //
 static void GIF_bwrwrite(UINT32 idata)
 {
-	gifbwr_bits_buf |= (idata << gifbwr_bits_num);
+	gifbwr_bits_buf |= ((UINT64)idata << gifbwr_bits_num);
 	gifbwr_bits_num += gifbwr_bits_min;
-	while (gifbwr_bits_num >= 8)
+	if (gifbwr_bits_num >= 32)
 	{
-		WRITEUINT8(gifbwr_cur, (UINT8)(gifbwr_bits_buf&0xFF));
-		gifbwr_bits_buf >>= 8;
-		gifbwr_bits_num -= 8;
-		++gifbwr_bufsize;
+		WRITEUINT32(gifbwr_cur, (UINT32)gifbwr_bits_buf); // little endian, like the bit order
+		gifbwr_bits_buf >>= 32;
+		gifbwr_bits_num -= 32;
+		gifbwr_bufsize += 4;
 	}
 }
 
@@ -236,10 +264,10 @@ static void GIF_bwrwrite(UINT32 idata)
 
 // SCReen BUFfer (obviously)
 // ---
-static UINT8 *scrbuf_pos;
-static UINT8 *scrbuf_linebegin;
-static UINT8 *scrbuf_lineend;
-static UINT8 *scrbuf_writeend;
+static const UINT8 *scrbuf_pos;
+static const UINT8 *scrbuf_linebegin;
+static const UINT8 *scrbuf_lineend;
+static const UINT8 *scrbuf_writeend;
 static INT16 scrbuf_downscaleamt = 1;
 
 
@@ -251,9 +279,17 @@ static INT16 scrbuf_downscaleamt = 1;
 #define GIFLZW_DICTSTART 0x102
 #define GIFLZW_MAXCODE 4096
 
+// The dictionary is an open addressing hash table, at most half full.
+// Entries are the key (prefix code and byte) above the code.
+#define GIFLZW_HASHBITS 13
+#define GIFLZW_HASHSIZE (1 << GIFLZW_HASHBITS)
+#define GIFLZW_HASH(key) (((key) * 2654435761u) >> (32 - GIFLZW_HASHBITS))
+
 static UINT16 giflzw_workingCode;
 static UINT16 giflzw_nextCodeToAssign;
-static UINT32 *giflzw_hashTable = NULL; // 16384 required
+static UINT32 *giflzw_hashTable = NULL;
+static UINT16 *giflzw_hashGen = NULL; // entries from older generations are empty
+static UINT16 giflzw_generation = 0;
 
 //
 // GIF_prepareLZW
@@ -264,52 +300,28 @@ static void GIF_prepareLZW(void)
 	gifbwr_bits_min = 9;
 	giflzw_nextCodeToAssign = GIFLZW_DICTSTART;
 
-	if (!giflzw_hashTable)
-		giflzw_hashTable = Z_Malloc(16384*sizeof(UINT32), PU_STATIC, NULL);
-	memset(giflzw_hashTable, 0, 16384*sizeof(UINT32));
-}
-
-//
-// GIF_searchHash
-// searches the LZW hash table for a match
-//
-static char GIF_searchHash(UINT32 key, UINT32 *pOutput)
-{
-	UINT32 entry, position = (key >> 6) & 0x3FFF;
-
-	while (giflzw_hashTable[position] != 0)
+	// empties the table, without clearing it every time
+	if (++giflzw_generation == 0)
 	{
-		entry = giflzw_hashTable[position];
-		if ((entry >> 12) == key)
-		{
-			*pOutput = (entry & 0xFFF);
-			return 1;
-		}
-
-		position = (position + 1) & 0x3FFF;
+		memset(giflzw_hashGen, 0, GIFLZW_HASHSIZE*sizeof(UINT16));
+		giflzw_generation = 1;
 	}
-
-	return 0;
 }
 
 //
-// GIF_addHash
-// stores a hash in the hash table
+// GIF_findHash
+// returns where the key is in the LZW hash table,
+// or the empty slot where it would go
 //
-static void GIF_addHash(UINT32 key, UINT32 value)
+static UINT32 GIF_findHash(UINT32 key)
 {
-	UINT32 position = (key >> 6) & 0x3FFF;
+	UINT32 position = GIFLZW_HASH(key);
 
-	for (;;)
-	{
-		if (giflzw_hashTable[position] == 0)
-		{
-			giflzw_hashTable[position] = (key << 12) | (value & 0xFFF);
-			return;
-		}
+	while (giflzw_hashGen[position] == giflzw_generation
+		&& (giflzw_hashTable[position] >> 12) != key)
+		position = (position + 1) & (GIFLZW_HASHSIZE - 1);
 
-		position = (position + 1) & 0x3FFF;
-	}
+	return position;
 }
 
 //
@@ -319,7 +331,7 @@ static void GIF_addHash(UINT32 key, UINT32 value)
 //
 static void GIF_feedByte(UINT8 pbyte)
 {
-	UINT32 key, hashOutput = 0;
+	UINT32 key, position;
 
 	// Prepare a code with this byte if we have none
 	if (giflzw_workingCode == UINT16_MAX)
@@ -331,8 +343,9 @@ static void GIF_feedByte(UINT8 pbyte)
 	// If we're here, this means we have a code in progress
 	// Is this string already in the dictionary?
 	key = (giflzw_workingCode << 8) | pbyte;
+	position = GIF_findHash(key);
 
-	if (0 == GIF_searchHash(key, &hashOutput))
+	if (giflzw_hashGen[position] != giflzw_generation)
 	{
 		// It wasn't found.
 		// That means we can output what we already had, and
@@ -342,7 +355,8 @@ static void GIF_feedByte(UINT8 pbyte)
 			++gifbwr_bits_min; // out of room, extend minbits
 
 		GIF_bwrwrite(giflzw_workingCode);
-		GIF_addHash(key, giflzw_nextCodeToAssign);
+		giflzw_hashTable[position] = (key << 12) | giflzw_nextCodeToAssign;
+		giflzw_hashGen[position] = giflzw_generation;
 		++giflzw_nextCodeToAssign;
 
 		// Seed the working code with this byte, for the next
@@ -352,7 +366,7 @@ static void GIF_feedByte(UINT8 pbyte)
 	}
 
 	// This string is in there, so update our working code!
-	giflzw_workingCode = hashOutput;
+	giflzw_workingCode = giflzw_hashTable[position] & 0xFFF;
 }
 
 //
@@ -371,12 +385,13 @@ static void GIF_lzw(void)
 		}
 		if ((scrbuf_pos += scrbuf_downscaleamt) >= scrbuf_lineend)
 		{
-			scrbuf_lineend += (vid.width * scrbuf_downscaleamt);
-			scrbuf_linebegin += (vid.width * scrbuf_downscaleamt);
+			scrbuf_lineend += (gif_width * scrbuf_downscaleamt);
+			scrbuf_linebegin += (gif_width * scrbuf_downscaleamt);
 			scrbuf_pos = scrbuf_linebegin;
 		}
-		// Just a bit of overflow prevention
-		if (gifbwr_bufsize >= 248)
+		// Just a bit of overflow prevention: up to 4 bytes can be
+		// written at once, plus 7 more when the stream ends
+		if (gifbwr_bufsize >= 240)
 			break;
 	}
 	if (scrbuf_pos > scrbuf_writeend)
@@ -415,7 +430,7 @@ const UINT8 gifhead_nsid[19] = {0x21,0xFF,0x0B, // extension block + size
 
 //
 // GIF_getpalette
-// determine the palette for the current frame.
+// determine the palette the GIF starts with.
 //
 static RGBA_t *GIF_getpalette(size_t palnum)
 {
@@ -433,15 +448,9 @@ static RGBA_t *GIF_getpalette(size_t palnum)
 // writes the gif palette.
 // used both for the header and local color tables.
 //
-static UINT8 *GIF_palwrite(UINT8 *p, RGBA_t *pal)
+static UINT8 *GIF_palwrite(UINT8 *p, const UINT8 *pal)
 {
-	INT32 i;
-	for (i = 0; i < 256; i++)
-	{
-		WRITEUINT8(p, pal[i].s.red);
-		WRITEUINT8(p, pal[i].s.green);
-		WRITEUINT8(p, pal[i].s.blue);
-	}
+	WRITEMEM(p, pal, 768);
 	return p;
 }
 
@@ -509,13 +518,11 @@ static size_t gifframe_size = 8192;
 #ifdef HWRENDER
 static colorlookup_t gif_colorlookup;
 
-static void GIF_rgbconvert(UINT8 *linear, UINT8 *scr)
+static void GIF_rgbconvert(const UINT8 *linear, UINT8 *scr)
 {
 	UINT8 r, g, b;
 	size_t src = 0, dest = 0;
-	size_t size = (vid.width * vid.height * 3);
-
-	InitColorLUT(&gif_colorlookup, (gif_localcolortable) ? gif_framepalette : gif_headerpalette, true);
+	size_t size = (gif_width * gif_height * 3);
 
 	while (src < size)
 	{
@@ -532,72 +539,42 @@ static void GIF_rgbconvert(UINT8 *linear, UINT8 *scr)
 //
 // GIF_framewrite
 // writes a frame into the file.
+// returns false if it couldn't.
 //
-static void GIF_framewrite(void)
+static boolean GIF_framewrite(const UINT8 *data, const UINT8 *palette, precise_t time)
 {
-	UINT8 *p;
-	UINT8 *movie_screen = screens[2];
+	UINT8 *p = gifframe_data;
+	const UINT8 *movie_screen = data;
 	INT32 blitx, blity, blitw, blith;
 	boolean palchanged;
 
-	if (!gifframe_data)
-		gifframe_data = Z_Malloc(gifframe_size, PU_STATIC, NULL);
-	p = gifframe_data;
-
 	if (!gif_out)
-		return;
+		return false;
 
-	// Lactozilla: Compare the header's palette with the current frame's palette and see if it changed.
-	if (gif_localcolortable)
+#ifdef HWRENDER
+	// Convert the OpenGL frame to the header's palette
+	if (gif_rgb)
 	{
-		gif_framepalette = GIF_getpalette(max(st_palette, 0));
-		palchanged = memcmp(gif_headerpalette, gif_framepalette, sizeof(RGBA_t) * 256);
+		GIF_rgbconvert(data, gif_curframe);
+		movie_screen = gif_curframe;
 	}
+#endif
+
+	// Lactozilla: Compare the header's palette with the current frame's palette and see if it changed.
+	if (gif_localcolortable && !gif_rgb)
+		palchanged = memcmp(gif_headerpalette, palette, sizeof gif_headerpalette);
 	else
 		palchanged = false;
 
 	// Compare image data (for optimizing GIF)
 	// If the palette has changed, the entire frame is considered to be different.
 	if (gif_optimize && gif_frames > 0 && (!palchanged))
-	{
-		// before blit movie_screen points to last frame, cur_screen points to this frame
-		UINT8 *cur_screen = screens[0];
-		GIF_optimizeregion(cur_screen, movie_screen, &blitx, &blity, &blitw, &blith);
-
-		// blit to temp screen
-		if (rendermode == render_soft)
-			I_ReadScreen(movie_screen);
-#ifdef HWRENDER
-		else if (rendermode == render_opengl)
-		{
-			UINT8 *linear = HWR_GetScreenshot();
-			GIF_rgbconvert(linear, movie_screen);
-			free(linear);
-		}
-#endif
-	}
+		GIF_optimizeregion(movie_screen, gif_prevframe, &blitx, &blity, &blitw, &blith);
 	else
 	{
 		blitx = blity = 0;
-		blitw = vid.width;
-		blith = vid.height;
-
-#ifdef HWRENDER
-		// Copy the current OpenGL frame into the base screen
-		if (rendermode == render_opengl)
-		{
-			UINT8 *linear = HWR_GetScreenshot();
-			GIF_rgbconvert(linear, screens[0]);
-			free(linear);
-		}
-#endif
-
-		// Copy the first frame into the movie screen
-		// OpenGL already does the same above.
-		if (gif_frames == 0 && rendermode == render_soft)
-			I_ReadScreen(movie_screen);
-
-		movie_screen = screens[0];
+		blitw = gif_width;
+		blith = gif_height;
 	}
 
 	// screen regions are handled in GIF_lzw
@@ -609,7 +586,7 @@ static void GIF_framewrite(void)
 		{
 			// golden's attempt at creating a "dynamic delay"
 			UINT16 mingifdelay = 10; // minimum gif delay in milliseconds (keep at 10 because gifs can't get more precise).
-			gif_delayus += (I_GetPreciseTime() - gif_prevframetime) / (I_GetPrecisePrecision() / 1000000); // increase delay by how much time was spent between last measurement
+			gif_delayus += (time - gif_prevframetime) / (I_GetPrecisePrecision() / 1000000); // increase delay by how much time was spent between last measurement
 
 			if (gif_delayus/1000 >= mingifdelay) // delay is big enough to be able to effect gif frame delay?
 			{
@@ -622,7 +599,7 @@ static void GIF_framewrite(void)
 		{
 			float delayf = ceil(100.0f/NEWTICRATE);
 
-			delay = (UINT16)((I_GetPreciseTime() - gif_prevframetime)) / (I_GetPrecisePrecision() / 1000000) /10/1000;
+			delay = (UINT16)((time - gif_prevframetime)) / (I_GetPrecisePrecision() / 1000000) /10/1000;
 
 			if (delay < (UINT16)(delayf))
 				delay = (UINT16)(delayf);
@@ -664,25 +641,23 @@ static void GIF_framewrite(void)
 			{
 				// The palettes are different, so write the Local Color Table!
 				WRITEUINT8(p, 0x87); // (0x87 = 1000 0111)
-				p = GIF_palwrite(p, gif_framepalette);
+				p = GIF_palwrite(p, palette);
 			}
 			else
 				WRITEUINT8(p, 0); // They are equal, no Local Color Table needed.
 		}
 
-		scrbuf_pos = movie_screen + blitx + (blity * vid.width);
-		scrbuf_writeend = scrbuf_pos + (blitw - 1) + ((blith - 1) * vid.width);
+		scrbuf_pos = movie_screen + blitx + (blity * gif_width);
+		scrbuf_writeend = scrbuf_pos + (blitw - 1) + ((blith - 1) * gif_width);
 
-		if (!gifbwr_buf)
-			gifbwr_buf = Z_Malloc(256, PU_STATIC, NULL);
 		gifbwr_cur = gifbwr_buf;
 
 		GIF_prepareLZW();
 		giflzw_workingCode = UINT16_MAX;
 		WRITEUINT8(p, gifbwr_bits_min - 1);
 
-		startline = (scrbuf_pos - movie_screen) / vid.width;
-		scrbuf_linebegin = movie_screen + (startline * vid.width) + blitx;
+		startline = (scrbuf_pos - movie_screen) / gif_width;
+		scrbuf_linebegin = movie_screen + (startline * gif_width) + blitx;
 		scrbuf_lineend = scrbuf_linebegin + blitw;
 
 		//prewrite a table clear
@@ -696,7 +671,11 @@ static void GIF_framewrite(void)
 			if ((size_t)(p - gifframe_data) + gifbwr_bufsize + 1 >= gifframe_size)
 			{
 				INT32 temppos = p - gifframe_data;
-				gifframe_data = Z_Realloc(gifframe_data, (gifframe_size *= 2), PU_STATIC, NULL);
+				UINT8 *newdata = realloc(gifframe_data, gifframe_size * 2);
+				if (!newdata)
+					return false;
+				gifframe_data = newdata;
+				gifframe_size *= 2;
 				p = gifframe_data + temppos; // realloc moves gifframe_data, so p is now invalid
 			}
 
@@ -710,9 +689,39 @@ static void GIF_framewrite(void)
 		}
 		WRITEUINT8(p, 0); //terminator
 	}
-	fwrite(gifframe_data, 1, (p - gifframe_data), gif_out);
+	if (fwrite(gifframe_data, 1, (p - gifframe_data), gif_out) != (size_t)(p - gifframe_data))
+		return false;
 	++gif_frames;
-	gif_prevframetime = I_GetPreciseTime();
+	gif_prevframetime = time;
+
+	// The next frame is compared with this one
+	if (gif_optimize)
+		M_Memcpy(gif_prevframe, movie_screen, gif_width * gif_height);
+	return true;
+}
+
+//
+// GIF_freebuffers
+// frees what the frames were encoded with.
+//
+static void GIF_freebuffers(void)
+{
+	free(gifbwr_buf);
+	gifbwr_buf = gifbwr_cur = NULL;
+
+	free(gifframe_data);
+	gifframe_data = NULL;
+
+	free(giflzw_hashTable);
+	giflzw_hashTable = NULL;
+	free(giflzw_hashGen);
+	giflzw_hashGen = NULL;
+	giflzw_generation = 0;
+
+	free(gif_curframe);
+	gif_curframe = NULL;
+	free(gif_prevframe);
+	gif_prevframe = NULL;
 }
 
 
@@ -727,6 +736,9 @@ static void GIF_framewrite(void)
 //
 INT32 GIF_open(const char *filename)
 {
+	RGBA_t *headerpalette;
+	INT32 i;
+
 	gif_out = fopen(filename, "wb");
 	if (!gif_out)
 		return 0;
@@ -736,7 +748,39 @@ INT32 GIF_open(const char *filename)
 	gif_dynamicdelay = (UINT8)cv_gif_dynamicdelay.value;
 	gif_localcolortable = (!!cv_gif_localcolortable.value);
 	gif_colorprofile = (!!cv_screenshot_colorprofile.value);
-	gif_headerpalette = GIF_getpalette(0);
+	gif_width = vid.width;
+	gif_height = vid.height;
+	gif_rgb = (rendermode != render_soft);
+
+	headerpalette = GIF_getpalette(0);
+	for (i = 0; i < 256; i++)
+	{
+		gif_headerpalette[i*3] = headerpalette[i].s.red;
+		gif_headerpalette[i*3+1] = headerpalette[i].s.green;
+		gif_headerpalette[i*3+2] = headerpalette[i].s.blue;
+	}
+#ifdef HWRENDER
+	if (gif_rgb)
+		InitColorLUT(&gif_colorlookup, headerpalette, true);
+#endif
+
+	gifframe_data = malloc(gifframe_size);
+	gifbwr_buf = malloc(256);
+	giflzw_hashTable = malloc(GIFLZW_HASHSIZE*sizeof(UINT32));
+	giflzw_hashGen = calloc(GIFLZW_HASHSIZE, sizeof(UINT16));
+	if (gif_rgb)
+		gif_curframe = calloc(gif_width * gif_height, 1);
+	if (gif_optimize)
+		gif_prevframe = malloc(gif_width * gif_height);
+
+	if (!gifframe_data || !gifbwr_buf || !giflzw_hashTable || !giflzw_hashGen
+		|| (gif_rgb && !gif_curframe) || (gif_optimize && !gif_prevframe))
+	{
+		GIF_freebuffers();
+		fclose(gif_out);
+		gif_out = NULL;
+		return 0;
+	}
 
 	GIF_headwrite();
 	gif_frames = 0;
@@ -747,12 +791,13 @@ INT32 GIF_open(const char *filename)
 
 //
 // GIF_frame
-// writes a frame into the output gif
+// writes a frame into the output gif.
+// data holds palette indices, or RGB in OpenGL, and palette is the
+// palette the frame was drawn with. time is when it was captured.
 //
-void GIF_frame(void)
+boolean GIF_frame(const UINT8 *data, const UINT8 *palette, precise_t time)
 {
-	// there's not much actually needed here, is there.
-	GIF_framewrite();
+	return GIF_framewrite(data, palette, time);
 }
 
 //
@@ -769,17 +814,7 @@ INT32 GIF_close(void)
 	fclose(gif_out);
 	gif_out = NULL;
 
-	if (gifbwr_buf)
-		Z_Free(gifbwr_buf);
-	gifbwr_buf = gifbwr_cur = NULL;
-
-	if (gifframe_data)
-		Z_Free(gifframe_data);
-	gifframe_data = NULL;
-
-	if (giflzw_hashTable)
-		Z_Free(giflzw_hashTable);
-	giflzw_hashTable = NULL;
+	GIF_freebuffers();
 
 	CONS_Printf(M_GetText("Animated gif closed; wrote %d frames\n"), gif_frames);
 	return 1;
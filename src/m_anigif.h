@@ -23,7 +23,7 @@
 
 #ifdef HAVE_ANIGIF
 INT32 GIF_open(const char *filename);
-void GIF_frame(void);
+boolean GIF_frame(const UINT8 *data, const UINT8 *palette, precise_t time);
 INT32 GIF_close(void);
 #endif
 
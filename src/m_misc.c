@@ -24,6 +24,7 @@
 #endif
 
 #include <errno.h>
+#include <signal.h>
 
 // Extended map support.
 #include <ctype.h>
@@ -43,6 +44,7 @@
 #include "m_argv.h"
 #include "i_system.h"
 #include "command.h" // cv_execversion
+#include "i_threads.h"
 
 #include "m_anigif.h"
 
@@ -107,11 +109,12 @@ consvar_t cv_screenshot_folder = CVAR_INIT ("screenshot_folder", "", CV_SAVE, NU
 
 consvar_t cv_screenshot_colorprofile = CVAR_INIT ("screenshot_colorprofile", "Yes", CV_SAVE, CV_YesNo, NULL);
 
-static CV_PossibleValue_t moviemode_cons_t[] = {{MM_GIF, "GIF"}, {MM_APNG, "aPNG"}, {MM_SCREENSHOT, "Screenshots"}, {0, NULL}};
+static CV_PossibleValue_t moviemode_cons_t[] = {{MM_GIF, "GIF"}, {MM_APNG, "aPNG"}, {MM_SCREENSHOT, "Screenshots"}, {MM_Y4M, "Y4M"}, {0, NULL}};
 consvar_t cv_moviemode = CVAR_INIT ("moviemode_mode", "GIF", CV_SAVE|CV_CALL, moviemode_cons_t, Moviemode_mode_Onchange);
 
 consvar_t cv_movie_option = CVAR_INIT ("movie_option", "Default", CV_SAVE|CV_CALL, screenshot_cons_t, Moviemode_option_Onchange);
 consvar_t cv_movie_folder = CVAR_INIT ("movie_folder", "", CV_SAVE, NULL, NULL);
+consvar_t cv_y4m_output = CVAR_INIT ("y4m_output", "", CV_SAVE, NULL, NULL);
 
 static CV_PossibleValue_t zlib_mem_level_t[] = {
 	{1, "(Min Memory) 1"},
@@ -741,6 +744,45 @@ static const char *Newsnapshotfile(const char *pathname, const char *ext)
 }
 #endif
 
+// ==========================================================================
+//                           MOVIE FRAME QUEUE
+// ==========================================================================
+// GIF, aPNG and Y4M frames are copied into a small ring of buffers by the main
+// thread, and encoded by a worker thread, so recording doesn't slow the
+// game down. When the queue is full, capturing waits for the encoder.
+// Without threads, frames are encoded as soon as they are captured.
+#if NUMSCREENS > 2
+#define MOVIEQUEUE_SIZE 8
+
+typedef struct
+{
+	UINT8 *data; // palette indices or 24-bit RGB, see movie_bpp
+	size_t size; // allocated size of data
+	UINT8 palette[768]; // palette at the time of capture
+	precise_t time; // when it was captured, for the GIF frame delays
+} movieframe_t;
+
+typedef boolean (*movieencoder_t)(movieframe_t *frame); // false on a write error
+
+static movieframe_t moviequeue[MOVIEQUEUE_SIZE];
+static INT32 moviequeue_head = 0; // next frame to encode
+static INT32 moviequeue_count = 0;
+
+// Format of the frames, fixed for the length of the movie
+static INT32 movie_width, movie_height;
+static INT32 movie_bpp; // 1 for palette indices (software), 3 for RGB (OpenGL)
+static movieencoder_t movie_encoder = NULL;
+static UINT32 movie_frames = 0; // frames captured so far
+static boolean movie_failed = false; // the encoder couldn't write, stop recording
+
+#ifdef HAVE_THREADS
+static I_mutex movie_mutex;
+static I_cond  movie_cond;
+static boolean movieworker_running = false; // cleared to make the worker finish up
+static boolean movieworker_done = true;
+#endif
+#endif
+
 #ifdef HAVE_PNG
 FUNCNORETURN static void PNG_error(png_structp PNG, png_const_charp pngtext)
 {
@@ -753,6 +795,16 @@ static void PNG_warn(png_structp PNG, png_const_charp pngtext)
 	CONS_Debug(DBG_RENDER, "libpng warning at %p: %s", PNG, pngtext);
 }
 
+#ifdef USE_APNG
+// Movie frames are encoded on a worker thread, where I_Error can't be called,
+// so errors jump back to the encoder instead.
+FUNCNORETURN static void aPNG_error(png_structp PNG, png_const_charp pngtext)
+{
+	CONS_Debug(DBG_RENDER, "libpng error at %p: %s", PNG, pngtext);
+	longjmp(png_jmpbuf(PNG), 1);
+}
+#endif
+
 static void M_PNGhdr(png_structp png_ptr, png_infop png_info_ptr, PNG_CONST png_uint_32 width, PNG_CONST png_uint_32 height, PNG_CONST png_byte *palette)
 {
 	const png_byte png_interlace = PNG_INTERLACE_NONE; //PNG_INTERLACE_ADAM7
@@ -893,6 +945,9 @@ static png_infop   apng_info_ptr = NULL;
 static apng_infop  apng_ainfo_ptr = NULL;
 static png_FILE_p  apng_FILE = NULL;
 static png_uint_32 apng_frames = 0;
+static png_uint_32 apng_width, apng_height, apng_scale;
+static png_bytep   apng_curframe = NULL; // downscaled frames, for finding what changed
+static png_bytep   apng_prevframe = NULL;
 #ifdef PNG_STATIC // Win32 build have static libpng
 #define aPNG_set_acTL png_set_acTL
 #define aPNG_write_frame_head png_write_frame_head
@@ -988,56 +1043,111 @@ static inline boolean M_PNGLib(void)
 #endif
 }
 
-static void M_PNGFrame(png_structp png_ptr, png_infop png_info_ptr, png_bytep png_buf)
+static boolean M_PNGRowEqual(png_uint_32 y)
 {
-	png_uint_16 downscale = apng_downscale ? vid.dup : 1;
+	const size_t pitch = apng_width * movie_bpp;
+	return !memcmp(apng_curframe + y*pitch, apng_prevframe + y*pitch, pitch);
+}
 
-	png_uint_32 pitch = png_get_rowbytes(png_ptr, png_info_ptr);
-	PNG_CONST png_uint_32 width = vid.width / downscale;
-	PNG_CONST png_uint_32 height = vid.height / downscale;
-	png_bytepp row_pointers = png_malloc(png_ptr, height * sizeof (png_bytep));
+static boolean M_PNGColumnEqual(png_uint_32 x, png_uint_32 top, png_uint_32 bottom)
+{
+	const size_t pitch = apng_width * movie_bpp;
+	png_uint_32 y;
+
+	for (y = top; y < bottom; y++)
+	{
+		if (memcmp(apng_curframe + y*pitch + x*movie_bpp,
+			apng_prevframe + y*pitch + x*movie_bpp, movie_bpp))
+			return false;
+	}
+
+	return true;
+}
+
+// Runs on the movie encoder thread
+static boolean M_PNGFrame(movieframe_t *frame)
+{
+	const size_t pitch = apng_width * movie_bpp;
+	const size_t srcpitch = (size_t)movie_width * movie_bpp;
+	png_bytepp row_pointers;
+	png_bytep swap;
+	png_uint_32 left = 0, right = apng_width;
+	png_uint_32 top = 0, bottom = apng_height;
 	png_uint_32 x, y;
 	png_uint_16 framedelay = (png_uint_16)cv_apng_delay.value;
 
-	apng_frames++;
+	if (setjmp(png_jmpbuf(apng_ptr)))
+		return false;
 
-	for (y = 0; y < height; y++)
+	for (y = 0; y < apng_height; y++)
 	{
-		row_pointers[y] = malloc(pitch * sizeof(png_byte));
-		for (x = 0; x < width; x++)
-			row_pointers[y][x] = png_buf[x * downscale];
-		png_buf += pitch * (downscale * downscale);
+		const UINT8 *src = frame->data + y * apng_scale * srcpitch;
+		UINT8 *dst = apng_curframe + y * pitch;
+
+		if (apng_scale == 1)
+			memcpy(dst, src, pitch);
+		else
+		{
+			for (x = 0; x < apng_width; x++)
+				memcpy(dst + x * movie_bpp, src + x * apng_scale * movie_bpp, movie_bpp);
+		}
 	}
-		//for (x = 0; x < width; x++)
-		//{
-		//	printf("%d", x);
-		//	row_pointers[y][x] = 0;
-		//}
-	/*	row_pointers[y] = calloc(1, sizeof(png_bytep));
-		png_buf += pitch * 2;
-	}*/
+
+	// Only write the part of the frame that changed.
+	// The first frame is also the default image, so it must be whole.
+	if (apng_frames > 0)
+	{
+		while (top < bottom && M_PNGRowEqual(top))
+			top++;
+
+		if (top == bottom) // nothing changed, but frames can't be empty
+		{
+			top = left = 0;
+			bottom = right = 1;
+		}
+		else
+		{
+			while (M_PNGRowEqual(bottom - 1))
+				bottom--;
+			while (M_PNGColumnEqual(left, top, bottom))
+				left++;
+			while (M_PNGColumnEqual(right - 1, top, bottom))
+				right--;
+		}
+	}
+
+	row_pointers = png_malloc(apng_ptr, (bottom - top) * sizeof (png_bytep));
+	for (y = top; y < bottom; y++)
+		row_pointers[y - top] = apng_curframe + y * pitch + left * movie_bpp;
 
 #ifndef PNG_STATIC
 	if (aPNG_write_frame_head)
 #endif
 		aPNG_write_frame_head(apng_ptr, apng_info_ptr, row_pointers,
-			width,     /* width */
-			height,    /* height */
-			0,         /* x offset */
-			0,         /* y offset */
+			right - left, /* width */
+			bottom - top, /* height */
+			left,      /* x offset */
+			top,       /* y offset */
 			framedelay, TICRATE,/* delay numerator and denominator */
-			PNG_DISPOSE_OP_BACKGROUND, /* dispose */
-			PNG_BLEND_OP_SOURCE        /* blend */
+			PNG_DISPOSE_OP_NONE, /* dispose */
+			PNG_BLEND_OP_SOURCE  /* blend */
 		                     );
 
-	png_write_image(png_ptr, row_pointers);
+	png_write_image(apng_ptr, row_pointers);
 
 #ifndef PNG_STATIC
 	if (aPNG_write_frame_tail)
 #endif
 		aPNG_write_frame_tail(apng_ptr, apng_info_ptr);
 
-	png_free(png_ptr, (png_voidp)row_pointers);
+	png_free(apng_ptr, (png_voidp)row_pointers);
+
+	swap = apng_prevframe;
+	apng_prevframe = apng_curframe;
+	apng_curframe = swap;
+
+	apng_frames++;
+	return true;
 }
 
 static void M_PNGfix_acTL(png_structp png_ptr, png_infop png_info_ptr,
@@ -1050,6 +1160,13 @@ static void M_PNGfix_acTL(png_structp png_ptr, png_infop png_info_ptr,
 #endif
 }
 
+static void M_FreeaPNGFrames(void)
+{
+	free(apng_curframe);
+	free(apng_prevframe);
+	apng_curframe = apng_prevframe = NULL;
+}
+
 static boolean M_SetupaPNG(png_const_charp filename, png_bytep pal)
 {
 	png_uint_16 downscale;
@@ -1058,10 +1175,24 @@ static boolean M_SetupaPNG(png_const_charp filename, png_bytep pal)
 
 	downscale = apng_downscale ? vid.dup : 1;
 
+	apng_scale = downscale;
+	apng_width = vid.width / downscale;
+	apng_height = vid.height / downscale;
+
+	apng_curframe = malloc(apng_width * apng_height * 3);
+	apng_prevframe = malloc(apng_width * apng_height * 3);
+	if (!apng_curframe || !apng_prevframe)
+	{
+		CONS_Debug(DBG_RENDER, "M_StartMovie: Error on allocate for frames\n");
+		M_FreeaPNGFrames();
+		return false;
+	}
+
 	apng_FILE = fopen(filename,"wb+"); // + mode for reading
 	if (!apng_FILE)
 	{
 		CONS_Debug(DBG_RENDER, "M_StartMovie: Error on opening %s for write\n", filename);
+		M_FreeaPNGFrames();
 		return false;
 	}
 
@@ -1072,6 +1203,7 @@ static boolean M_SetupaPNG(png_const_charp filename, png_bytep pal)
 		CONS_Debug(DBG_RENDER, "M_StartMovie: Error on initialize libpng\n");
 		fclose(apng_FILE);
 		remove(filename);
+		M_FreeaPNGFrames();
 		return false;
 	}
 
@@ -1082,6 +1214,7 @@ static boolean M_SetupaPNG(png_const_charp filename, png_bytep pal)
 		png_destroy_write_struct(&apng_ptr,  NULL);
 		fclose(apng_FILE);
 		remove(filename);
+		M_FreeaPNGFrames();
 		return false;
 	}
 
@@ -1092,6 +1225,7 @@ static boolean M_SetupaPNG(png_const_charp filename, png_bytep pal)
 		png_destroy_write_struct(&apng_ptr, &apng_info_ptr);
 		fclose(apng_FILE);
 		remove(filename);
+		M_FreeaPNGFrames();
 		return false;
 	}
 
@@ -1118,6 +1252,9 @@ static boolean M_SetupaPNG(png_const_charp filename, png_bytep pal)
 
 	apng_write_info(apng_ptr, apng_info_ptr, apng_ainfo_ptr);
 
+	// From here on, libpng is used by the movie encoder thread
+	png_set_error_fn(apng_ptr, png_get_error_ptr(apng_ptr), aPNG_error, PNG_warn);
+
 	apng_frames = 0;
 
 	return true;
@@ -1129,6 +1266,280 @@ static boolean M_SetupaPNG(png_const_charp filename, png_bytep pal)
 //                             MOVIE MODE
 // ==========================================================================
 #if NUMSCREENS > 2
+#ifdef HAVE_THREADS
+static void M_MovieWorker(void *userdata)
+{
+	movieframe_t *frame;
+	boolean ok;
+
+	(void)userdata;
+
+	I_lock_mutex(&movie_mutex);
+	for (;;)
+	{
+		while (moviequeue_count == 0 && movieworker_running)
+			I_hold_cond(&movie_cond, movie_mutex);
+
+		if (moviequeue_count == 0) // stopped, and everything was encoded
+			break;
+
+		frame = &moviequeue[moviequeue_head];
+		I_unlock_mutex(movie_mutex);
+
+		// After an error, drop frames until the main thread stops the movie
+		ok = !movie_failed && movie_encoder(frame);
+
+		I_lock_mutex(&movie_mutex);
+		if (!ok)
+			movie_failed = true;
+		moviequeue_head = (moviequeue_head + 1) % MOVIEQUEUE_SIZE;
+		moviequeue_count--;
+		I_wake_all_cond(&movie_cond);
+	}
+
+	movieworker_done = true;
+	I_wake_all_cond(&movie_cond);
+	I_unlock_mutex(movie_mutex);
+}
+#endif
+
+static void M_StartMovieQueue(movieencoder_t encoder)
+{
+	movie_width = vid.width;
+	movie_height = vid.height;
+	movie_bpp = (rendermode == render_soft) ? 1 : 3;
+	movie_encoder = encoder;
+	movie_frames = 0;
+	movie_failed = false;
+	moviequeue_head = moviequeue_count = 0;
+
+#ifdef HAVE_THREADS
+	movieworker_running = true;
+	movieworker_done = false;
+	I_spawn_thread("movie-encoder", M_MovieWorker, NULL);
+#endif
+
+	// finish the file properly if the game quits while recording
+	I_AddExitFunc(M_StopMovie);
+}
+
+// Waits for every queued frame to be encoded
+static void M_StopMovieQueue(void)
+{
+	INT32 i;
+
+#ifdef HAVE_THREADS
+	I_lock_mutex(&movie_mutex);
+	movieworker_running = false;
+	I_wake_all_cond(&movie_cond);
+	while (!movieworker_done)
+		I_hold_cond(&movie_cond, movie_mutex);
+	I_unlock_mutex(movie_mutex);
+#endif
+
+	I_RemoveExitFunc(M_StopMovie);
+
+	for (i = 0; i < MOVIEQUEUE_SIZE; i++)
+	{
+		free(moviequeue[i].data);
+		moviequeue[i].data = NULL;
+		moviequeue[i].size = 0;
+	}
+}
+
+static boolean M_QueueMovieFrame(void)
+{
+	movieframe_t *frame;
+	const size_t size = (size_t)movie_width * movie_height * movie_bpp;
+#ifdef HAVE_THREADS
+	boolean failed;
+#endif
+
+	if (vid.width != movie_width || vid.height != movie_height
+		|| movie_bpp != ((rendermode == render_soft) ? 1 : 3))
+	{
+		CONS_Alert(CONS_NOTICE, M_GetText("Resolution or renderer changed while recording\n"));
+		return false;
+	}
+
+#ifdef HAVE_THREADS
+	I_lock_mutex(&movie_mutex);
+	while (moviequeue_count == MOVIEQUEUE_SIZE && !movie_failed) // wait for the encoder to catch up
+		I_hold_cond(&movie_cond, movie_mutex);
+	frame = &moviequeue[(moviequeue_head + moviequeue_count) % MOVIEQUEUE_SIZE];
+	failed = movie_failed;
+	I_unlock_mutex(movie_mutex);
+	if (failed)
+	{
+		CONS_Alert(CONS_ERROR, M_GetText("Error writing movie\n"));
+		return false;
+	}
+#else
+	frame = &moviequeue[0];
+#endif
+
+	if (rendermode == render_soft)
+	{
+		if (frame->size < size)
+		{
+			UINT8 *data = realloc(frame->data, size);
+			if (!data)
+				return false;
+			frame->data = data;
+			frame->size = size;
+		}
+
+		I_ReadScreen(frame->data);
+		M_CreateScreenShotPalette();
+		memcpy(frame->palette, screenshot_palette, sizeof frame->palette);
+	}
+	else
+	{
+#ifdef HWRENDER
+		free(frame->data);
+		frame->data = HWR_GetScreenshot();
+		frame->size = frame->data ? size : 0;
+		if (!frame->data)
+			return false;
+#else
+		return false;
+#endif
+	}
+
+	frame->time = I_GetPreciseTime();
+	movie_frames++;
+
+#ifdef HAVE_THREADS
+	I_lock_mutex(&movie_mutex);
+	moviequeue_count++;
+	I_wake_all_cond(&movie_cond);
+	I_unlock_mutex(movie_mutex);
+#else
+	if (!movie_encoder(frame))
+	{
+		CONS_Alert(CONS_ERROR, M_GetText("Error writing movie\n"));
+		return false;
+	}
+#endif
+
+	return true;
+}
+
+// Y4M is raw video, meant to be read by an external encoder. The output
+// can be a named pipe that the encoder reads from, see y4m_output.
+static FILE *y4m_file = NULL;
+static UINT8 *y4m_planes = NULL; // 4:2:0, the Y plane then the U and V planes
+#ifdef SIGPIPE
+static void (*y4m_oldsigpipe)(int); // a closed pipe must fail the write, not kill the game
+#endif
+
+static inline const UINT8 *M_MovieFramePixel(const movieframe_t *frame, INT32 x, INT32 y)
+{
+	if (movie_bpp == 1)
+		return &frame->palette[frame->data[y * movie_width + x] * 3];
+	return &frame->data[(y * movie_width + x) * 3];
+}
+
+// Runs on the movie encoder thread
+static boolean M_Y4MFrame(movieframe_t *frame)
+{
+	const INT32 chromawidth = (movie_width + 1) / 2;
+	const INT32 chromaheight = (movie_height + 1) / 2;
+	UINT8 *yplane = y4m_planes;
+	UINT8 *uplane = yplane + movie_width * movie_height;
+	UINT8 *vplane = uplane + chromawidth * chromaheight;
+	const UINT8 *rgb;
+	INT32 x, y, i, j;
+
+	// BT.601, limited range
+	for (y = 0; y < movie_height; y++)
+	{
+		for (x = 0; x < movie_width; x++)
+		{
+			rgb = M_MovieFramePixel(frame, x, y);
+			*yplane++ = (UINT8)((66*rgb[0] + 129*rgb[1] + 25*rgb[2] + 4224) >> 8);
+		}
+	}
+
+	// Each chroma sample is the average of a 2x2 block
+	for (y = 0; y < chromaheight; y++)
+	{
+		for (x = 0; x < chromawidth; x++)
+		{
+			INT32 r = 0, g = 0, b = 0, n = 0;
+
+			for (j = y*2; j < y*2 + 2 && j < movie_height; j++)
+			{
+				for (i = x*2; i < x*2 + 2 && i < movie_width; i++)
+				{
+					rgb = M_MovieFramePixel(frame, i, j);
+					r += rgb[0];
+					g += rgb[1];
+					b += rgb[2];
+					n++;
+				}
+			}
+
+			r /= n;
+			g /= n;
+			b /= n;
+			*uplane++ = (UINT8)((-38*r - 74*g + 112*b + 32896) >> 8);
+			*vplane++ = (UINT8)((112*r - 94*g - 18*b + 32896) >> 8);
+		}
+	}
+
+	// A short write means the encoder on the other end of the pipe is gone
+	return (fputs("FRAME\n", y4m_file) != EOF
+		&& fwrite(y4m_planes, 1, vplane - y4m_planes, y4m_file) == (size_t)(vplane - y4m_planes));
+}
+
+static inline moviemode_t M_StartMovieY4M(const char *pathname)
+{
+	const char *filename;
+	const INT32 chromasize = ((vid.width + 1) / 2) * ((vid.height + 1) / 2);
+
+	if (*cv_y4m_output.string != '\0')
+		filename = cv_y4m_output.string;
+	else
+	{
+		const char *freename = Newsnapshotfile(pathname,"y4m");
+
+		if (!freename)
+		{
+			CONS_Alert(CONS_ERROR, "Couldn't create Y4M: no slots open in %s\n", pathname);
+			return MM_OFF;
+		}
+
+		filename = va(pandf,pathname,freename);
+	}
+
+	y4m_planes = malloc(vid.width * vid.height + 2 * chromasize);
+	if (!y4m_planes)
+	{
+		CONS_Alert(CONS_ERROR, "Couldn't create Y4M: out of memory\n");
+		return MM_OFF;
+	}
+
+	// A named pipe blocks here, until the encoder opens the other end
+	y4m_file = fopen(filename, "wb");
+	if (!y4m_file)
+	{
+		CONS_Alert(CONS_ERROR, "Couldn't create Y4M: error opening %s\n", filename);
+		free(y4m_planes);
+		y4m_planes = NULL;
+		return MM_OFF;
+	}
+
+#ifdef SIGPIPE
+	y4m_oldsigpipe = signal(SIGPIPE, SIG_IGN);
+#endif
+
+	fprintf(y4m_file, "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C420jpeg\n", vid.width, vid.height, TICRATE);
+
+	M_StartMovieQueue(M_Y4MFrame);
+	return MM_Y4M;
+}
+
 static inline moviemode_t M_StartMovieAPNG(const char *pathname)
 {
 #ifdef USE_APNG
@@ -1161,6 +1572,8 @@ static inline moviemode_t M_StartMovieAPNG(const char *pathname)
 		CONS_Alert(CONS_ERROR, "Couldn't create aPNG: error creating %s in %s\n", freename, pathname);
 		return MM_OFF;
 	}
+
+	M_StartMovieQueue(M_PNGFrame);
 	return MM_APNG;
 #else
 	// no APNG support exists
@@ -1170,6 +1583,14 @@ static inline moviemode_t M_StartMovieAPNG(const char *pathname)
 #endif
 }
 
+#ifdef HAVE_ANIGIF
+// Runs on the movie encoder thread
+static boolean M_GIFFrame(movieframe_t *frame)
+{
+	return GIF_frame(frame->data, frame->palette, frame->time);
+}
+#endif
+
 static inline moviemode_t M_StartMovieGIF(const char *pathname)
 {
 #ifdef HAVE_ANIGIF
@@ -1186,6 +1607,8 @@ static inline moviemode_t M_StartMovieGIF(const char *pathname)
 		CONS_Alert(CONS_ERROR, "Couldn't create GIF: error creating %s in %s\n", freename, pathname);
 		return MM_OFF;
 	}
+
+	M_StartMovieQueue(M_GIFFrame);
 	return MM_GIF;
 #else
 	// no GIF support exists
@@ -1233,6 +1656,9 @@ void M_StartMovie(void)
 		case MM_SCREENSHOT:
 			moviemode = MM_SCREENSHOT;
 			break;
+		case MM_Y4M:
+			moviemode = M_StartMovieY4M(pathname);
+			break;
 		default: //???
 			return;
 	}
@@ -1243,6 +1669,8 @@ void M_StartMovie(void)
 		CONS_Printf(M_GetText("Movie mode enabled (%s).\n"), "GIF");
 	else if (moviemode == MM_SCREENSHOT)
 		CONS_Printf(M_GetText("Movie mode enabled (%s).\n"), "screenshots");
+	else if (moviemode == MM_Y4M)
+		CONS_Printf(M_GetText("Movie mode enabled (%s).\n"), "Y4M");
 
 	//singletics = (moviemode != MM_OFF);
 #endif
@@ -1265,42 +1693,16 @@ void M_SaveFrame(void)
 			takescreenshot = true;
 			return;
 		case MM_GIF:
-			GIF_frame();
-			return;
 		case MM_APNG:
+		case MM_Y4M:
+			if (!M_QueueMovieFrame())
+				M_StopMovie();
 #ifdef USE_APNG
+			else if (moviemode == MM_APNG && movie_frames == PNG_UINT_31_MAX)
 			{
-				UINT8 *linear = NULL;
-				if (!apng_FILE) // should not happen!!
-				{
-					moviemode = MM_OFF;
-					return;
-				}
-
-				if (rendermode == render_soft)
-				{
-					// munge planar buffer to linear
-					linear = screens[2];
-					I_ReadScreen(linear);
-				}
-#ifdef HWRENDER
-				else
-					linear = HWR_GetScreenshot();
-#endif
-				M_PNGFrame(apng_ptr, apng_info_ptr, (png_bytep)linear);
-#ifdef HWRENDER
-				if (rendermode != render_soft && linear)
-					free(linear);
-#endif
-
-				if (apng_frames == PNG_UINT_31_MAX)
-				{
-					CONS_Alert(CONS_NOTICE, M_GetText("Max movie size reached\n"));
-					M_StopMovie();
-				}
+				CONS_Alert(CONS_NOTICE, M_GetText("Max movie size reached\n"));
+				M_StopMovie();
 			}
-#else
-			moviemode = MM_OFF;
 #endif
 			return;
 		default:
@@ -1315,21 +1717,34 @@ void M_StopMovie(void)
 	switch (moviemode)
 	{
 		case MM_GIF:
+#ifdef HAVE_ANIGIF
+			M_StopMovieQueue();
 			if (!GIF_close())
 				return;
 			break;
+#else
+			return;
+#endif
 		case MM_APNG:
 #ifdef USE_APNG
 			if (!apng_FILE)
 				return;
 
-			if (apng_frames)
+			M_StopMovieQueue();
+
+			if (apng_frames && !movie_failed)
 			{
-				M_PNGfix_acTL(apng_ptr, apng_info_ptr, apng_ainfo_ptr);
-				apng_write_end(apng_ptr, apng_info_ptr, apng_ainfo_ptr);
+				if (setjmp(png_jmpbuf(apng_ptr)))
+					CONS_Alert(CONS_ERROR, M_GetText("Error writing movie\n"));
+				else
+				{
+					M_PNGfix_acTL(apng_ptr, apng_info_ptr, apng_ainfo_ptr);
+					apng_write_end(apng_ptr, apng_info_ptr, apng_ainfo_ptr);
+				}
 			}
 
 			png_destroy_write_struct(&apng_ptr, &apng_info_ptr);
+			M_FreeaPNGFrames();
 
 			fclose(apng_FILE);
 			apng_FILE = NULL;
@@ -1341,6 +1756,21 @@ void M_StopMovie(void)
 #endif
 		case MM_SCREENSHOT:
 			break;
+		case MM_Y4M:
+			if (!y4m_file)
+				return;
+
+			M_StopMovieQueue();
+
+			fclose(y4m_file);
+			y4m_file = NULL;
+#ifdef SIGPIPE
+			signal(SIGPIPE, y4m_oldsigpipe);
+#endif
+			free(y4m_planes);
+			y4m_planes = NULL;
+			CONS_Printf("Y4M closed; wrote %u frames\n", movie_frames);
+			break;
 		default:
 			return;
 	}
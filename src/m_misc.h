@@ -25,12 +25,13 @@ typedef enum {
 	MM_OFF = 0,
 	MM_APNG,
 	MM_GIF,
-	MM_SCREENSHOT
+	MM_SCREENSHOT,
+	MM_Y4M
 } moviemode_t;
 extern moviemode_t moviemode;
 
 extern consvar_t cv_screenshot_option, cv_screenshot_folder, cv_screenshot_colorprofile;
-extern consvar_t cv_moviemode, cv_movie_folder, cv_movie_option;
+extern consvar_t cv_moviemode, cv_movie_folder, cv_movie_option, cv_y4m_output;
 extern consvar_t cv_zlib_memory, cv_zlib_level, cv_zlib_strategy, cv_zlib_window_bits;
 extern consvar_t cv_zlib_memorya, cv_zlib_levela, cv_zlib_strategya, cv_zlib_window_bitsa;
 extern consvar_t cv_apng_delay, cv_apng_downscale;
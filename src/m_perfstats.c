@@ -123,6 +123,8 @@ perfstatrow_t commoncounter_rows[] = {
 	{"sprites", "Sprites:     ", &ps_numsprites, 0},
 	{"drwnode", "Drawnodes:   ", &ps_numdrawnodes, 0},
 	{"plyobjs", "Polyobjects: ", &ps_numpolyobjects, 0},
+	{"tcmhits", "Colormap hit:", &ps_numtranslationhits, 0},
+	{"tcmmiss", "Colormap new:", &ps_numtranslationmisses, 0},
 	{0}
 };
 
@@ -53,6 +53,7 @@
 #include "gamestate.h"
 #include "commands.h"
 #include "protocol.h"
+#include "desync_log.h"
 
 //
 // NETWORKING
@@ -1247,6 +1248,20 @@ void GetPackets(void)
 	}
 }
 
+/** Runs one game tic, with the bookkeeping that goes with it
+  */
+void D_RunTic(void)
+{
+	DEBFILE(va("============ Running tic %d (local %d)\n", gametic, localgametic));
+
+	G_Ticker((gametic % NEWTICRATERATIO) == 0);
+	ExtraDataTicker();
+	gametic++;
+	consistancy[gametic%BACKUPTICS] = Consistancy();
+	if (desynclogging)
+		D_LogDesyncTic();
+}
+
 boolean TryRunTics(tic_t realtics)
 {
 	// the machine has lagged but it is not so bad
@@ -1308,15 +1323,10 @@ boolean TryRunTics(tic_t realtics)
 			{
 				boolean update_stats = !(paused || P_AutoPause());
 
-				DEBFILE(va("============ Running tic %d (local %d)\n", gametic, localgametic));
-
 				if (update_stats)
 					PS_START_TIMING(ps_tictime);
 
-				G_Ticker((gametic % NEWTICRATERATIO) == 0);
-				ExtraDataTicker();
-				gametic++;
-				consistancy[gametic%BACKUPTICS] = Consistancy();
+				D_RunTic();
 
 				if (update_stats)
 				{
@@ -1658,6 +1668,8 @@ void D_ClientServerInit(void)
 	COM_AddCommand("reloadbans", Command_ReloadBan, COM_LUA);
 	COM_AddCommand("connect", Command_connect, COM_LUA);
 	COM_AddCommand("nodes", Command_Nodes, COM_LUA);
+	COM_AddCommand("desynclog", Command_DesyncLog_f, 0);
+	COM_AddCommand("desyncdiff", Command_DesyncDiff_f, 0);
 	COM_AddCommand("set_http_login", Command_set_http_login, 0);
 	COM_AddCommand("list_http_logins", Command_list_http_logins, 0);
 	COM_AddCommand("resendgamestate", Command_ResendGamestate, COM_LUA);
@@ -108,6 +108,8 @@ void D_QuitNetGame(void);
 
 //? How many ticks to run?
 boolean TryRunTics(tic_t realtic);
+// Runs a single tic, also used to skip ahead in demos
+void D_RunTic(void);
 
 // extra data for lmps
 // these functions scare me. they contain magic.
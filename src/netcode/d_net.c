@@ -91,11 +91,13 @@ INT32 getbytes = 0;
 INT64 sendbytes = 0;
 static INT32 retransmit = 0, duppacket = 0;
 static INT32 sendackpacket = 0, getackpacket = 0;
+static INT32 sendsizecount[NETSTATSIZEBUCKETS], sendmaxcount = 0;
 INT32 ticruned = 0, ticmiss = 0;
 
 // globals
 INT32 getbps, sendbps;
 float lostpercent, duppercent, gamelostpercent;
+INT32 sendsizehist[NETSTATSIZEBUCKETS], sendmaxsize;
 INT32 packetheaderlength;
 
 boolean Net_GetNetStat(void)
@@ -121,6 +123,11 @@ boolean Net_GetNetStat(void)
 		else
 			gamelostpercent = 0.0f;
 
+		M_Memcpy(sendsizehist, sendsizecount, sizeof (sendsizehist));
+		memset(sendsizecount, 0, sizeof (sendsizecount));
+		sendmaxsize = sendmaxcount;
+		sendmaxcount = 0;
+
 		ticmiss = ticruned = 0;
 		oldsendbyte = sendbytes;
 		getbytes = 0;
@@ -1012,6 +1019,14 @@ boolean HSendPacket(INT32 node, boolean reliable, UINT8 acknum, size_t packetlen
 
 	netbuffer->checksum = NetbufferChecksum();
 	sendbytes += packetheaderlength + doomcom->datalength; // For stat
+	{
+		const INT32 size = packetheaderlength + doomcom->datalength;
+		INT32 bucket = 0;
+		while (bucket < NETSTATSIZEBUCKETS-1 && size > (64 << bucket))
+			bucket++;
+		sendsizecount[bucket]++;
+		sendmaxcount = max(sendmaxcount, size);
+	}
 
 #ifdef PACKETDROP
 	// Simulate internet :)
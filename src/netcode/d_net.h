@@ -29,11 +29,13 @@
 //#define NETSPLITSCREEN // Kart's splitscreen netgame feature
 
 #define STATLENGTH (TICRATE*2)
+#define NETSTATSIZEBUCKETS 6 // Sent packet sizes up to 64, 128, 256, 512, 1024 bytes and above
 
 // stat of net
 extern INT32 ticruned, ticmiss;
 extern INT32 getbps, sendbps;
 extern float lostpercent, duppercent, gamelostpercent;
+extern INT32 sendsizehist[NETSTATSIZEBUCKETS], sendmaxsize; // Packets sent per size bucket, largest packet
 extern INT32 packetheaderlength;
 boolean Net_GetNetStat(void);
 extern INT32 getbytes;
@@ -51,6 +51,7 @@
 #include "../m_anigif.h"
 #include "../md5.h"
 #include "../m_perfstats.h"
+#include "../lua_profile.h"
 #include "../u_list.h"
 
 #ifdef NETGAME_DEVMODE
@@ -119,6 +120,7 @@ static void Fishcake_OnChange(void);
 static void Command_Playdemo_f(void);
 static void Command_Timedemo_f(void);
 static void Command_Stopdemo_f(void);
+static void Command_Demoseek_f(void);
 static void Command_StartMovie_f(void);
 static void Command_StopMovie_f(void);
 static void Command_Map_f(void);
@@ -396,7 +398,18 @@ static CV_PossibleValue_t ps_descriptor_cons_t[] = {
 	{1, "Average"}, {2, "SD"}, {3, "Minimum"}, {4, "Maximum"}, {0, NULL}};
 consvar_t cv_ps_descriptor = CVAR_INIT ("ps_descriptor", "Average", 0, ps_descriptor_cons_t, NULL);
 
+static CV_PossibleValue_t luagc_idle_cons_t[] = {{0, "MIN"}, {100, "MAX"}, {0, NULL}};
+consvar_t cv_luagc_idle = CVAR_INIT ("luagc_idle", "50", CV_SAVE, luagc_idle_cons_t, NULL);
+static CV_PossibleValue_t luagc_stepsize_cons_t[] = {{1, "MIN"}, {1024, "MAX"}, {0, NULL}};
+consvar_t cv_luagc_stepsize = CVAR_INIT ("luagc_stepsize", "4", CV_SAVE, luagc_stepsize_cons_t, NULL);
+static CV_PossibleValue_t luagc_param_cons_t[] = {{100, "MIN"}, {1000, "MAX"}, {0, NULL}};
+consvar_t cv_luagc_pause = CVAR_INIT ("luagc_pause", "200", CV_SAVE|CV_CALL, luagc_param_cons_t, LUA_SetGCParams);
+consvar_t cv_luagc_stepmul = CVAR_INIT ("luagc_stepmul", "200", CV_SAVE|CV_CALL, luagc_param_cons_t, LUA_SetGCParams);
+consvar_t cv_luacache = CVAR_INIT ("luacache", "On", CV_SAVE, CV_OnOff, NULL);
+
 consvar_t cv_freedemocamera = CVAR_INIT("freedemocamera", "Off", CV_SAVE, CV_OnOff, NULL);
+static CV_PossibleValue_t demokeyframes_cons_t[] = {{1, "MIN"}, {300, "MAX"}, {0, "Off"}, {0, NULL}};
+consvar_t cv_demokeyframes = CVAR_INIT ("demokeyframes", "10", CV_SAVE, demokeyframes_cons_t, NULL);
 
 // NOTE: this should be in hw_main.c, but we can't put it there as it breaks dedicated build
 consvar_t cv_glallowshaders = CVAR_INIT ("gr_allowcustomshaders", "On", CV_NETVAR, CV_OnOff, NULL);
@@ -691,6 +704,7 @@ void D_RegisterClientCommands(void)
 	COM_AddCommand("playdemo", Command_Playdemo_f, 0);
 	COM_AddCommand("timedemo", Command_Timedemo_f, 0);
 	COM_AddCommand("stopdemo", Command_Stopdemo_f, COM_LUA);
+	COM_AddCommand("demoseek", Command_Demoseek_f, 0);
 	COM_AddCommand("playintro", Command_Playintro_f, COM_LUA);
 
 	COM_AddCommand("resetcamera", Command_ResetCamera_f, COM_LUA);
@@ -708,6 +722,7 @@ void D_RegisterClientCommands(void)
 	CV_RegisterVar(&cv_moviemode);
 	CV_RegisterVar(&cv_movie_option);
 	CV_RegisterVar(&cv_movie_folder);
+	CV_RegisterVar(&cv_y4m_output);
 	// PNG variables
 	CV_RegisterVar(&cv_zlib_level);
 	CV_RegisterVar(&cv_zlib_memory);
@@ -922,6 +937,13 @@ void D_RegisterClientCommands(void)
 	CV_RegisterVar(&cv_ps_samplesize);
 	CV_RegisterVar(&cv_ps_descriptor);
 
+	COM_AddCommand("luaprofile", Command_LuaProfile_f, 0);
+	CV_RegisterVar(&cv_luagc_idle);
+	CV_RegisterVar(&cv_luagc_stepsize);
+	CV_RegisterVar(&cv_luagc_pause);
+	CV_RegisterVar(&cv_luagc_stepmul);
+	CV_RegisterVar(&cv_luacache);
+
 	// ingame object placing
 	COM_AddCommand("objectplace", Command_ObjectPlace_f, COM_LUA);
 	COM_AddCommand("writethings", Command_Writethings_f, COM_LUA);
@@ -931,6 +953,7 @@ void D_RegisterClientCommands(void)
 	CV_RegisterVar(&cv_mapthingnum);
 
 	CV_RegisterVar(&cv_freedemocamera);
+	CV_RegisterVar(&cv_demokeyframes);
 
 	// add cheat commands
 	COM_AddCommand("noclip", Command_CheatNoClip_f, COM_LUA);
@@ -1675,6 +1698,43 @@ static void Command_Stopdemo_f(void)
 	CONS_Printf(M_GetText("Stopped demo.\n"));
 }
 
+// demoseek <[+|-]seconds or minutes:seconds>
+static void Command_Demoseek_f(void)
+{
+	const char *arg;
+	INT32 sign = 0;
+	INT32 seconds;
+	INT32 target;
+	const char *colon;
+
+	if (COM_Argc() != 2)
+	{
+		CONS_Printf(M_GetText("demoseek <time>: jump to a time in the demo being played\n"
+			"Time is seconds or minutes:seconds, +/- for relative to now\n"));
+		return;
+	}
+
+	arg = COM_Argv(1);
+
+	if (*arg == '+' || *arg == '-')
+		sign = (*arg++ == '+') ? 1 : -1;
+
+	colon = strchr(arg, ':');
+	if (colon)
+		seconds = atoi(arg)*60 + atoi(colon + 1);
+	else
+		seconds = atoi(arg);
+
+	target = seconds * TICRATE;
+	if (sign)
+		target = (INT32)G_DemoTic() + sign*target;
+
+	if (target < 0)
+		target = 0;
+
+	G_SeekDemo((UINT32)target);
+}
+
 static void Command_StartMovie_f(void)
 {
 	M_StartMovie();
@@ -116,12 +116,16 @@ extern consvar_t cv_perfstats;
 extern consvar_t cv_ps_samplesize;
 extern consvar_t cv_ps_descriptor;
 
+extern consvar_t cv_luagc_idle, cv_luagc_stepsize, cv_luagc_pause, cv_luagc_stepmul;
+extern consvar_t cv_luacache;
+
 extern char timedemo_name[256];
 extern boolean timedemo_csv;
 extern char timedemo_csv_id[256];
 extern boolean timedemo_quit;
 
 extern consvar_t cv_freedemocamera;
+extern consvar_t cv_demokeyframes;
 
 typedef enum
 {
@@ -35,6 +35,11 @@
 #include <sys/utime.h>
 #endif
 
+#ifdef UNIXCOMMON
+#include <fcntl.h>
+#include <sys/mman.h>
+#endif
+
 #include "../doomdef.h"
 #include "../doomstat.h"
 #include "../d_main.h"
@@ -74,6 +79,20 @@ typedef struct filetx_s
 	struct filetx_s *next; // Next file in the list
 } filetx_t;
 
+// A file being sent, shared by every node downloading it
+typedef struct filecache_s
+{
+	char *filename;
+	UINT8 *data;
+	UINT32 size;
+	INT32 refcount;
+#ifdef UNIXCOMMON
+	boolean mapped; // Data is mmapped rather than read into memory
+#endif
+	struct filecache_s *next;
+} filecache_t;
+static filecache_t *filecache = NULL;
+
 // Current transfers (one for each node)
 typedef struct filetran_s
 {
@@ -83,8 +102,15 @@ typedef struct filetran_s
 	UINT32 position; // The current position in the file
 	boolean *ackedfragments;
 	UINT32 ackedsize;
-	FILE *currentfile; // The file currently being sent/received
+	filecache_t *cache; // The file currently being sent, NULL for RAM
+	const UINT8 *data; // What is being sent, NULL if not started yet
 	tic_t dontsenduntil;
+
+	// Congestion control, see SV_FileFragmentAcked
+	UINT32 window; // Fragments that may be unacknowledged at once, in 1/256ths
+	UINT32 ssthresh; // Window size where slow start ends, in fragments
+	UINT32 inflight; // Fragments sent but not acknowledged yet
+	tic_t lastacktime;
 } filetran_t;
 static filetran_t transfer[MAXNETNODES];
 
@@ -954,6 +980,117 @@ boolean AddLuaFileToSendQueue(INT32 node, const char *filename)
 	return true;
 }
 
+/** Opens a file for sending, or shares it with the nodes already downloading it
+  *
+  * \param filename The file to open
+  * \return The cached file
+  * \sa SV_CloseCachedFile
+  *
+  */
+static filecache_t *SV_OpenCachedFile(const char *filename)
+{
+	filecache_t *cache;
+
+	for (cache = filecache; cache; cache = cache->next)
+		if (!strcmp(cache->filename, filename))
+		{
+			cache->refcount++;
+			return cache;
+		}
+
+	cache = calloc(1, sizeof (*cache));
+	if (!cache)
+		I_Error("SV_OpenCachedFile: No more memory\n");
+	cache->filename = malloc(strlen(filename) + 1);
+	if (!cache->filename)
+		I_Error("SV_OpenCachedFile: No more memory\n");
+	strcpy(cache->filename, filename);
+
+#ifdef UNIXCOMMON
+	{
+		// Let the OS page the file in rather than holding a copy of it
+		struct stat st;
+		int fd = open(filename, O_RDONLY);
+
+		if (fd != -1)
+		{
+			if (fstat(fd, &st) == 0 && st.st_size > 0 && st.st_size < LONG_MAX)
+			{
+				void *map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+				if (map != MAP_FAILED)
+				{
+					cache->data = map;
+					cache->size = (UINT32)st.st_size;
+					cache->mapped = true;
+				}
+			}
+			close(fd);
+		}
+	}
+
+	if (!cache->mapped)
+#endif
+	{
+		FILE *f = fopen(filename, "rb");
+		long filesize;
+
+		if (!f)
+			I_Error("File %s does not exist", filename);
+
+		fseek(f, 0, SEEK_END);
+		filesize = ftell(f);
+
+		// Nobody wants to transfer a file bigger
+		// than 4GB!
+		if (filesize >= LONG_MAX)
+			I_Error("filesize of %s is too large", filename);
+		if (filesize == -1)
+			I_Error("Error getting filesize of %s", filename);
+
+		cache->size = (UINT32)filesize;
+		cache->data = malloc(cache->size ? cache->size : 1);
+		if (!cache->data)
+			I_Error("SV_OpenCachedFile: No more memory\n");
+
+		fseek(f, 0, SEEK_SET);
+		if (fread(cache->data, 1, cache->size, f) != cache->size)
+			I_Error("SV_OpenCachedFile: can't read %s because %s", filename, M_FileError(f));
+		fclose(f);
+	}
+
+	cache->refcount = 1;
+	cache->next = filecache;
+	filecache = cache;
+	return cache;
+}
+
+/** Releases a file opened with SV_OpenCachedFile,
+  * freeing it once no node is downloading it anymore
+  *
+  * \param cache The cached file
+  *
+  */
+static void SV_CloseCachedFile(filecache_t *cache)
+{
+	filecache_t **p;
+
+	if (--cache->refcount > 0)
+		return;
+
+	for (p = &filecache; *p != cache; p = &(*p)->next)
+		;
+	*p = cache->next;
+
+#ifdef UNIXCOMMON
+	if (cache->mapped)
+		munmap(cache->data, cache->size);
+	else
+#endif
+		free(cache->data);
+	free(cache->filename);
+	free(cache);
+}
+
 /** Stops sending a file for a node, and removes the file request from the list,
   * either because the file has been fully sent or because the node was disconnected
   *
@@ -971,8 +1108,8 @@ static void SV_EndFileSend(INT32 node)
 		case SF_FILE: // It's a file, close it and free its filename
 			if (cv_noticedownload.value)
 				CONS_Printf("Ending file transfer for node %d\n", node);
-			if (transfer[node].currentfile)
-				fclose(transfer[node].currentfile);
+			if (transfer[node].cache)
+				SV_CloseCachedFile(transfer[node].cache);
 			free(p->id.filename);
 			break;
 		case SF_Z_RAM: // It's a memory block allocated with Z_Alloc or the likes, use Z_Free
@@ -989,7 +1126,8 @@ static void SV_EndFileSend(INT32 node)
 	free(p);
 
 	// Indicate that the transmission is over
-	transfer[node].currentfile = NULL;
+	transfer[node].cache = NULL;
+	transfer[node].data = NULL;
 	if (transfer[node].ackedfragments)
 		free(transfer[node].ackedfragments);
 	transfer[node].ackedfragments = NULL;
@@ -998,159 +1136,185 @@ static void SV_EndFileSend(INT32 node)
 }
 
 #define FILEFRAGMENTSIZE (software_MAXPACKETLENGTH - (FILETXHEADER + BASEPACKETSIZE))
+#define FILEWINDOWSTART 4 // In fragments
+#define MAXFILEWINDOW 1024 // In fragments
 
-/** Handles file transmission
+/** Shrinks the window of a transfer after fragments were lost,
+  * the same way TCP Reno does
   *
   */
-void FileSendTicker(void)
+static void SV_FileTransferLost(filetran_t *trans)
 {
-	static INT32 currentnode = 0;
-	filetx_pak *p;
-	size_t fragmentsize;
-	filetx_t *f;
-	INT32 packetsent, ram, i, j;
+	trans->ssthresh = max(trans->window >> 9, 2);
+	trans->window = trans->ssthresh << 8;
+	trans->inflight = 0;
+}
 
-	// If someone is taking too long to download, kick them with a timeout
-	// to prevent blocking the rest of the server...
-	if (luafiletransfers)
-	{
-		for (i = 1; i < MAXNETNODES; i++)
-		{
-			luafiletransfernodestatus_t status = luafiletransfers->nodestatus[i];
+/** Grows the window of a transfer when a fragment is acknowledged,
+  * by one fragment per ack during slow start, then by one fragment
+  * per window's worth of acks
+  *
+  */
+static void SV_FileFragmentAcked(filetran_t *trans)
+{
+	if (trans->inflight)
+		trans->inflight--;
 
-			if (status != LFTNS_NONE && status != LFTNS_WAITING && status != LFTNS_SENT
-				&& I_GetTime() > luafiletransfers->nodetimeouts[i])
-			{
-				Net_ConnectionTimeout(i);
-			}
-		}
-	}
+	if ((trans->window >> 8) < trans->ssthresh)
+		trans->window += 256;
+	else
+		trans->window += 65536 / trans->window;
+	trans->window = min(trans->window, MAXFILEWINDOW << 8);
 
-	if (!filestosend) // No file to send
-		return;
+	trans->lastacktime = I_GetTime();
+}
+
+/** Starts a new pass over the file, to resend what hasn't been acknowledged
+  *
+  */
+static void SV_NextFileIteration(filetran_t *trans)
+{
+	// If the client hasn't acknowledged any fragment from the previous iteration,
+	// it is most likely because their acks haven't had enough time to reach the server
+	// yet, due to latency. In that case, we wait a little to avoid useless resend.
+	if (trans->ackediteration < trans->iteration)
+		trans->dontsenduntil = I_GetTime() + TICRATE / 2;
+
+	// Whatever is still unacknowledged after the first pass was most likely lost
+	if (trans->iteration > 1)
+		SV_FileTransferLost(trans);
+	else
+		trans->inflight = 0;
 
-	packetsent = cv_downloadspeed.value;
+	trans->position = 0;
+	trans->iteration++;
+}
 
-	netbuffer->packettype = PT_FILEFRAGMENT;
+/** Sends as many fragments to a node as its window allows
+  *
+  * \param node The destination
+  *
+  */
+static void SV_SendFileFragments(INT32 node)
+{
+	filetran_t *trans = &transfer[node];
+	filetx_t *f = trans->txlist;
+	filetx_pak *p = &netbuffer->u.filetxpak;
+	INT32 budget;
 
-	// (((sendbytes-nowsentbyte)*TICRATE)/(I_GetTime()-starttime)<(UINT32)net_bandwidth)
-	while (packetsent-- && filestosend != 0)
+	// Open the file if it isn't open yet
+	if (!trans->data)
 	{
-		for (i = currentnode, j = 0; j < MAXNETNODES;
-			i = (i+1) % MAXNETNODES, j++)
+		if (!f->ram) // Sending a file
 		{
-			if (transfer[i].txlist)
-				break;
+			trans->cache = SV_OpenCachedFile(f->id.filename);
+			trans->data = trans->cache->data;
+			f->size = trans->cache->size;
 		}
-		// no transfer to do
-		if (j >= MAXNETNODES)
-			I_Error("filestosend=%d but no file to send found\n", filestosend);
-
-		currentnode = (i+1) % MAXNETNODES;
-		f = transfer[i].txlist;
-		ram = f->ram;
-
-		// Open the file if it isn't open yet, or
-		if (!transfer[i].currentfile)
-		{
-			if (!ram) // Sending a file
-			{
-				long filesize;
-
-				transfer[i].currentfile =
-					fopen(f->id.filename, "rb");
+		else // Sending RAM
+			trans->data = (const UINT8 *)f->id.ram;
 
-				if (!transfer[i].currentfile)
-					I_Error("File %s does not exist",
-						f->id.filename);
+		trans->iteration = 1;
+		trans->ackediteration = 0;
+		trans->position = 0;
+		trans->ackedsize = 0;
 
-				fseek(transfer[i].currentfile, 0, SEEK_END);
-				filesize = ftell(transfer[i].currentfile);
+		trans->ackedfragments = calloc(f->size / FILEFRAGMENTSIZE + 1, sizeof(*trans->ackedfragments));
+		if (!trans->ackedfragments)
+			I_Error("FileSendTicker: No more memory\n");
 
-				// Nobody wants to transfer a file bigger
-				// than 4GB!
-				if (filesize >= LONG_MAX)
-					I_Error("filesize of %s is too large", f->id.filename);
-				if (filesize == -1)
-					I_Error("Error getting filesize of %s", f->id.filename);
+		trans->dontsenduntil = 0;
 
-				f->size = (UINT32)filesize;
-				fseek(transfer[i].currentfile, 0, SEEK_SET);
-			}
-			else // Sending RAM
-				transfer[i].currentfile = (FILE *)1; // Set currentfile to a non-null value to indicate that it is open
+		trans->window = FILEWINDOWSTART << 8;
+		trans->ssthresh = MAXFILEWINDOW;
+		trans->inflight = 0;
+		trans->lastacktime = I_GetTime();
+	}
 
-			transfer[i].iteration = 1;
-			transfer[i].ackediteration = 0;
-			transfer[i].position = 0;
-			transfer[i].ackedsize = 0;
+	if (I_GetTime() < trans->dontsenduntil)
+		return;
 
-			transfer[i].ackedfragments = calloc(f->size / FILEFRAGMENTSIZE + 1, sizeof(*transfer[i].ackedfragments));
-			if (!transfer[i].ackedfragments)
-				I_Error("FileSendTicker: No more memory\n");
+	// Nothing has been acknowledged for a while, assume the window was lost
+	if (trans->inflight && I_GetTime() - trans->lastacktime > TICRATE)
+	{
+		SV_FileTransferLost(trans);
+		trans->lastacktime = I_GetTime();
+	}
 
-			transfer[i].dontsenduntil = 0;
-		}
+	budget = min(cv_downloadspeed.value, (INT32)(trans->window >> 8) - (INT32)trans->inflight);
 
-		// If the client hasn't acknowledged any fragment from the previous iteration,
-		// it is most likely because their acks haven't had enough time to reach the server
-		// yet, due to latency. In that case, we wait a little to avoid useless resend.
-		if (I_GetTime() < transfer[i].dontsenduntil)
-			continue;
+	while (budget-- > 0 && I_GetTime() >= trans->dontsenduntil)
+	{
+		size_t fragmentsize;
 
 		// Find the first non-acknowledged fragment
-		while (transfer[i].ackedfragments[transfer[i].position / FILEFRAGMENTSIZE])
+		while (trans->ackedfragments[trans->position / FILEFRAGMENTSIZE])
 		{
-			transfer[i].position += FILEFRAGMENTSIZE;
-			if (transfer[i].position >= f->size)
-			{
-				if (transfer[i].ackediteration < transfer[i].iteration)
-					transfer[i].dontsenduntil = I_GetTime() + TICRATE / 2;
-
-				transfer[i].position = 0;
-				transfer[i].iteration++;
-			}
+			trans->position += FILEFRAGMENTSIZE;
+			if (trans->position >= f->size)
+				SV_NextFileIteration(trans);
 		}
 
 		// Build a packet containing a file fragment
-		p = &netbuffer->u.filetxpak;
 		fragmentsize = FILEFRAGMENTSIZE;
-		if (f->size-transfer[i].position < fragmentsize)
-			fragmentsize = f->size-transfer[i].position;
-		if (ram)
-			M_Memcpy(p->data, &f->id.ram[transfer[i].position], fragmentsize);
-		else
-		{
-			fseek(transfer[i].currentfile, transfer[i].position, SEEK_SET);
-
-			if (fread(p->data, 1, fragmentsize, transfer[i].currentfile) != fragmentsize)
-				I_Error("FileSendTicker: can't read %s byte on %s at %d because %s", sizeu1(fragmentsize), f->id.filename, transfer[i].position, M_FileError(transfer[i].currentfile));
-		}
-		p->iteration = transfer[i].iteration;
-		p->position = LONG(transfer[i].position);
+		if (f->size-trans->position < fragmentsize)
+			fragmentsize = f->size-trans->position;
+		M_Memcpy(p->data, &trans->data[trans->position], fragmentsize);
+		p->iteration = trans->iteration;
+		p->position = LONG(trans->position);
 		p->fileid = f->fileid;
 		p->filesize = LONG(f->size);
 		p->size = SHORT((UINT16)FILEFRAGMENTSIZE);
 
 		// Send the packet
-		if (HSendPacket(i, false, 0, FILETXHEADER + fragmentsize)) // Don't use the default acknowledgement system
-		{ // Success
-			transfer[i].position = (UINT32)(transfer[i].position + fragmentsize);
-			if (transfer[i].position >= f->size)
-			{
-				if (transfer[i].ackediteration < transfer[i].iteration)
-					transfer[i].dontsenduntil = I_GetTime() + TICRATE / 2;
+		if (!HSendPacket(node, false, 0, FILETXHEADER + fragmentsize)) // Don't use the default acknowledgement system
+			break; // Not sent for some odd reason, retry at next call
+
+		trans->inflight++;
+		trans->position = (UINT32)(trans->position + fragmentsize);
+		if (trans->position >= f->size)
+			SV_NextFileIteration(trans);
+	}
+}
+
+/** Handles file transmission
+  *
+  */
+void FileSendTicker(void)
+{
+	static INT32 currentnode = 0;
+	INT32 i;
+
+	// If someone is taking too long to download, kick them with a timeout
+	// to prevent blocking the rest of the server...
+	if (luafiletransfers)
+	{
+		for (i = 1; i < MAXNETNODES; i++)
+		{
+			luafiletransfernodestatus_t status = luafiletransfers->nodestatus[i];
 
-				transfer[i].position = 0;
-				transfer[i].iteration++;
+			if (status != LFTNS_NONE && status != LFTNS_WAITING && status != LFTNS_SENT
+				&& I_GetTime() > luafiletransfers->nodetimeouts[i])
+			{
+				Net_ConnectionTimeout(i);
 			}
 		}
-		else
-		{ // Not sent for some odd reason, retry at next call
-			// Exit the while (can't send this one so why should i send the next?)
-			break;
-		}
 	}
+
+	if (!filestosend) // No file to send
+		return;
+
+	netbuffer->packettype = PT_FILEFRAGMENT;
+
+	// Every node has its own window, start from a different one
+	// each tic so the same node isn't always the last to send
+	for (INT32 j = 0; j < MAXNETNODES; j++)
+	{
+		i = (currentnode + j) % MAXNETNODES;
+		if (transfer[i].txlist)
+			SV_SendFileFragments(i);
+	}
+	currentnode = (currentnode + 1) % MAXNETNODES;
 }
 
 void PT_FileAck(SINT8 node)
@@ -1162,7 +1326,7 @@ void PT_FileAck(SINT8 node)
 		return;
 
 	// Wrong file id? Ignore it, it's probably a late packet
-	if (!(trans->txlist && packet->fileid == trans->txlist->fileid))
+	if (!(trans->txlist && trans->ackedfragments && packet->fileid == trans->txlist->fileid))
 		return;
 
 	if (packet->numsegments * sizeof(*packet->segments) != doomcom->datalength - BASEPACKETSIZE - sizeof(*packet))
@@ -1185,16 +1349,19 @@ void PT_FileAck(SINT8 node)
 		for (INT32 j = 0; j < 32; j++)
 			if (LONG(segment->acks) & (1 << j))
 			{
-				if (LONG(segment->start) * FILEFRAGMENTSIZE >= trans->txlist->size)
+				UINT32 fragment = LONG(segment->start) + j;
+
+				if ((UINT64)fragment * FILEFRAGMENTSIZE >= trans->txlist->size)
 				{
 					Net_CloseConnection(node);
 					return;
 				}
 
-				if (!trans->ackedfragments[LONG(segment->start) + j])
+				if (!trans->ackedfragments[fragment])
 				{
-					trans->ackedfragments[LONG(segment->start) + j] = true;
-					trans->ackedsize += FILEFRAGMENTSIZE;
+					trans->ackedfragments[fragment] = true;
+					trans->ackedsize += min(FILEFRAGMENTSIZE, trans->txlist->size - fragment * FILEFRAGMENTSIZE);
+					SV_FileFragmentAcked(trans);
 
 					// If the last missing fragment was acked, finish!
 					if (trans->ackedsize == trans->txlist->size)
@@ -1294,6 +1461,55 @@ void FileReceiveTicker(void)
 	}
 }
 
+#define FILEWRITEBUFFERSIZE (256*1024)
+
+/** Writes the fragments queued by CL_WriteFileFragment to the file
+  *
+  */
+static void CL_FlushFileWrites(fileneeded_t *file)
+{
+	if (!file->writesize)
+		return;
+
+	// We can receive packets in the wrong order, anyway all OSes support gaped files
+	fseek(file->file, file->writestart, SEEK_SET);
+	if (fwrite(file->writebuffer, file->writesize, 1, file->file) != 1)
+		I_Error("Can't write to %s: %s\n", file->filename, M_FileError(file->file));
+	file->writesize = 0;
+}
+
+/** Queues a fragment for writing, so fragments arriving in order
+  * end up in a few large writes rather than one seek and write each
+  *
+  */
+static void CL_WriteFileFragment(fileneeded_t *file, UINT32 position, const UINT8 *data, UINT32 size)
+{
+	if (!file->writebuffer)
+	{
+		file->writebuffer = malloc(FILEWRITEBUFFERSIZE);
+		if (!file->writebuffer)
+			I_Error("CL_WriteFileFragment: No more memory\n");
+		file->writesize = 0;
+	}
+
+	if (file->writesize
+		&& (position != file->writestart + file->writesize
+		|| file->writesize + size > FILEWRITEBUFFERSIZE))
+		CL_FlushFileWrites(file);
+
+	if (!file->writesize)
+		file->writestart = position;
+	M_Memcpy(&file->writebuffer[file->writesize], data, size);
+	file->writesize += size;
+}
+
+static void CL_FreeFileWrites(fileneeded_t *file)
+{
+	free(file->writebuffer);
+	file->writebuffer = NULL;
+	file->writesize = 0;
+}
+
 static void OpenNewFileForDownload(fileneeded_t *file, const char *filename)
 {
 	file->file = fopen(filename, "wb");
@@ -1366,6 +1582,9 @@ void PT_FileFragment(SINT8 node, INT32 netconsole)
 		file->status = FS_DOWNLOADING;
 		file->fragmentsize = fragmentsize;
 		file->iteration = 0;
+		file->writebuffer = NULL;
+		file->writesize = 0;
+		file->downloadstart = I_GetPreciseTime();
 
 		file->ackpacket = calloc(1, sizeof(*file->ackpacket) + 512);
 		if (!file->ackpacket)
@@ -1416,10 +1635,8 @@ void PT_FileFragment(SINT8 node, INT32 netconsole)
 		{
 			file->receivedfragments[fragmentpos / fragmentsize] = true;
 
-			// We can receive packets in the wrong order, anyway all OSes support gaped files
-			fseek(file->file, fragmentpos, SEEK_SET);
-			if (fragmentsize && fwrite(netbuffer->u.filetxpak.data, boundedfragmentsize, 1, file->file) != 1)
-				I_Error("Can't write to %s: %s\n",file->filename, M_FileError(file->file));
+			if (fragmentsize)
+				CL_WriteFileFragment(file, fragmentpos, netbuffer->u.filetxpak.data, boundedfragmentsize);
 			file->currentsize += boundedfragmentsize;
 
 			AddFragmentToAckPacket(file->ackpacket, file->iteration, fragmentpos / fragmentsize, filenum);
@@ -1427,6 +1644,10 @@ void PT_FileFragment(SINT8 node, INT32 netconsole)
 			// Finished?
 			if (file->currentsize == file->totalsize)
 			{
+				double seconds = (double)(I_GetPreciseTime() - file->downloadstart) / I_GetPrecisePrecision();
+
+				CL_FlushFileWrites(file);
+				CL_FreeFileWrites(file);
 				fclose(file->file);
 				file->file = NULL;
 				free(file->receivedfragments);
@@ -1453,7 +1674,8 @@ void PT_FileFragment(SINT8 node, INT32 netconsole)
 					filedownload.remaining--;
 				}
 
-				CONS_Printf(M_GetText("Finished download of \"%s\"\n"), filename);
+				CONS_Printf(M_GetText("Finished download of \"%s\" (%.2f MB/s)\n"), filename,
+					seconds > 0.0 ? file->totalsize / (1024.0 * 1024.0) / seconds : 0.0);
 			}
 		}
 		else // Already received
@@ -1525,6 +1747,9 @@ void CloseNetFile(void)
 		for (INT32 i = 0; i < fileneedednum; i++)
 			if (fileneeded[i].status == FS_DOWNLOADING && fileneeded[i].file)
 			{
+				// Write what was received, so a resumed download can skip it
+				CL_FlushFileWrites(&fileneeded[i]);
+				CL_FreeFileWrites(&fileneeded[i]);
 				fclose(fileneeded[i].file);
 				free(fileneeded[i].ackpacket);
 
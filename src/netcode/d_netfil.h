@@ -81,6 +81,9 @@ typedef struct
 	UINT32 currentsize;
 	UINT32 totalsize;
 	UINT32 ackresendposition; // Used when resuming downloads
+	UINT8 *writebuffer; // Contiguous fragments not written to the file yet
+	UINT32 writestart, writesize;
+	precise_t downloadstart;
 } fileneeded_t;
 
 #define FILENEEDEDSIZE 23
@@ -0,0 +1,596 @@
+// SONIC ROBO BLAST 2
+//-----------------------------------------------------------------------------
+// Copyright (C) 2024 by Sonic Team Junior.
+//
+// This program is free software distributed under the
+// terms of the GNU General Public License, version 2.
+// See the 'LICENSE' file for more details.
+//-----------------------------------------------------------------------------
+/// \file  desync_log.c
+/// \brief Per-tic world state hashes, for finding where a desync started
+///
+/// Consistancy() only tells that a client went out of sync, not why.
+/// While "desynclog" runs, every tic hashes each mobj, sector and polyobject
+/// field by field, and logs the objects whose hashes changed since the last
+/// tic. Both sides of a desync record a log, then "desyncdiff" replays the
+/// two and names the first object and fields that differ.
+
+#include "desync_log.h"
+#include "../doomdef.h"
+#include "../doomstat.h"
+#include "../d_main.h" // srb2home
+#include "../g_game.h" // levelstarttic
+#include "../command.h"
+#include "../console.h"
+#include "../byteptr.h"
+#include "../m_misc.h"
+#include "../p_local.h"
+#include "../p_polyobj.h"
+#include "../r_state.h"
+#include "../deh_tables.h" // MOBJTYPE_LIST, FREE_MOBJS
+#include "../z_zone.h"
+
+#define DESYNCLOGHEADER "SRB2DSYN"
+#define DESYNCLOGVERSION 1
+
+#define MAXDESYNCFIELDS 8
+
+typedef enum
+{
+	DK_MOBJ,
+	DK_SECTOR,
+	DK_POLYOBJ,
+	NUMDESYNCKINDS
+} desynckind_t;
+
+static const char *const kindnames[NUMDESYNCKINDS] = {"mobj", "sector", "polyobj"};
+
+static const UINT8 numfields[NUMDESYNCKINDS] = {8, 6, 4};
+
+static const char *const fieldnames[NUMDESYNCKINDS][MAXDESYNCFIELDS] = {
+	{"position", "momentum", "angle", "state", "flags", "health", "size", "links"},
+	{"floor", "ceiling", "light", "special", "physics", "thinkers"},
+	{"position", "angle", "flags", "thinker"},
+};
+
+typedef struct
+{
+	UINT16 type; // mobj type, sector special, polyobject id
+	UINT16 fields[MAXDESYNCFIELDS];
+} desyncobject_t;
+
+typedef struct
+{
+	desyncobject_t *objects[NUMDESYNCKINDS];
+	UINT32 count[NUMDESYNCKINDS];
+	UINT32 max[NUMDESYNCKINDS];
+} desyncworld_t;
+
+boolean desynclogging = false;
+
+static FILE *logfile = NULL;
+static desyncworld_t worlds[2];
+static desyncworld_t *previous = &worlds[0], *current = &worlds[1];
+static INT16 loggedmap;
+static tic_t loggedlevelstart;
+static UINT8 *record = NULL;
+static size_t recordsize = 0;
+
+//
+// Hashing
+//
+
+// One round of xxHash32. Cheap, and every input bit reaches every output bit.
+#define PRIME32_1 2654435761U
+#define PRIME32_2 2246822519U
+#define PRIME32_3 3266489917U
+
+static inline UINT32 HashRound(UINT32 h, UINT32 v)
+{
+	h += v * PRIME32_2;
+	h = (h << 13) | (h >> 19);
+	return h * PRIME32_1;
+}
+
+static inline UINT16 HashFinish(UINT32 h)
+{
+	h ^= h >> 15;
+	h *= PRIME32_2;
+	h ^= h >> 13;
+	h *= PRIME32_3;
+	h ^= h >> 16;
+	return (UINT16)(h ^ (h >> 16));
+}
+
+#define H(v) h = HashRound(h, (UINT32)(v))
+#define FIELD(n) do { obj->fields[n] = HashFinish(h); h = n + 1; } while (0)
+
+static void HashMobj(const mobj_t *mo, desyncobject_t *obj)
+{
+	UINT32 h = 0;
+
+	obj->type = (UINT16)mo->type;
+
+	H(mo->x); H(mo->y); H(mo->z);
+	FIELD(0);
+	H(mo->momx); H(mo->momy); H(mo->momz);
+	FIELD(1);
+	H(mo->angle); H(mo->pitch); H(mo->roll);
+	FIELD(2);
+	H(mo->state - states); H(mo->tics); H(mo->sprite); H(mo->sprite2); H(mo->frame);
+	FIELD(3);
+	H(mo->flags); H(mo->flags2); H(mo->eflags);
+	FIELD(4);
+	H(mo->health); H(mo->fuse); H(mo->threshold); H(mo->reactiontime); H(mo->movecount);
+	H(mo->extravalue1); H(mo->extravalue2);
+	FIELD(5);
+	H(mo->radius); H(mo->height); H(mo->scale); H(mo->destscale);
+	FIELD(6);
+	// Pointers differ between machines, what they point to shouldn't
+	if (mo->target)
+	{
+		H(mo->target->type); H(mo->target->x); H(mo->target->y); H(mo->target->z);
+	}
+	if (mo->tracer)
+	{
+		H(mo->tracer->type); H(mo->tracer->x); H(mo->tracer->y); H(mo->tracer->z);
+	}
+	FIELD(7);
+}
+
+static void HashSector(const sector_t *sec, desyncobject_t *obj)
+{
+	UINT32 h = 0;
+
+	obj->type = (UINT16)sec->special;
+
+	H(sec->floorheight); H(sec->floorpic); H(sec->floorxoffset); H(sec->flooryoffset); H(sec->floorangle);
+	FIELD(0);
+	H(sec->ceilingheight); H(sec->ceilingpic); H(sec->ceilingxoffset); H(sec->ceilingyoffset); H(sec->ceilingangle);
+	FIELD(1);
+	H(sec->lightlevel); H(sec->floorlightlevel); H(sec->ceilinglightlevel);
+	FIELD(2);
+	H(sec->special); H(sec->flags); H(sec->specialflags); H(sec->damagetype); H(sec->crumblestate);
+	FIELD(3);
+	H(sec->gravity); H(sec->friction);
+	FIELD(4);
+	H(sec->floordata != NULL); H(sec->ceilingdata != NULL); H(sec->lightingdata != NULL);
+	FIELD(5);
+}
+
+static void HashPolyobj(const polyobj_t *po, desyncobject_t *obj)
+{
+	UINT32 h = 0;
+
+	obj->type = (UINT16)po->id;
+
+	H(po->centerPt.x); H(po->centerPt.y);
+	FIELD(0);
+	H(po->angle);
+	FIELD(1);
+	H(po->flags); H(po->translucency);
+	FIELD(2);
+	H(po->thinker != NULL);
+	FIELD(3);
+}
+
+#undef H
+#undef FIELD
+
+static desyncobject_t *WorldObject(desyncworld_t *world, desynckind_t kind, UINT32 index)
+{
+	if (index >= world->max[kind])
+	{
+		world->max[kind] = max(index + 1, world->max[kind] * 2);
+		world->objects[kind] = Z_Realloc(world->objects[kind], world->max[kind] * sizeof (desyncobject_t), PU_STATIC, NULL);
+	}
+
+	return &world->objects[kind][index];
+}
+
+static void HashWorld(desyncworld_t *world)
+{
+	thinker_t *th;
+	UINT32 i;
+
+	world->count[DK_MOBJ] = 0;
+	for (th = thlist[THINK_MOBJ].next; th != &thlist[THINK_MOBJ]; th = th->next)
+	{
+		if (th->function.acp1 == (actionf_p1)P_RemoveThinkerDelayed)
+			continue;
+
+		HashMobj((mobj_t *)th, WorldObject(world, DK_MOBJ, world->count[DK_MOBJ]));
+		world->count[DK_MOBJ]++;
+	}
+
+	for (i = 0; i < numsectors; i++)
+		HashSector(&sectors[i], WorldObject(world, DK_SECTOR, i));
+	world->count[DK_SECTOR] = (UINT32)numsectors;
+
+	for (i = 0; i < (UINT32)numPolyObjects; i++)
+		HashPolyobj(&PolyObjects[i], WorldObject(world, DK_POLYOBJ, i));
+	world->count[DK_POLYOBJ] = (UINT32)numPolyObjects;
+}
+
+static UINT32 WorldHash(const desyncworld_t *world)
+{
+	UINT32 h = 0;
+	UINT32 i;
+	INT32 kind;
+	UINT8 f;
+
+	for (kind = 0; kind < NUMDESYNCKINDS; kind++)
+	{
+		h = HashRound(h, world->count[kind]);
+
+		for (i = 0; i < world->count[kind]; i++)
+		{
+			const desyncobject_t *obj = &world->objects[kind][i];
+
+			h = HashRound(h, obj->type);
+			for (f = 0; f < numfields[kind]; f++)
+				h = HashRound(h, obj->fields[f]);
+		}
+	}
+
+	return h;
+}
+
+static boolean SameObject(const desyncobject_t *a, const desyncobject_t *b, desynckind_t kind)
+{
+	return a->type == b->type && !memcmp(a->fields, b->fields, numfields[kind] * sizeof (UINT16));
+}
+
+//
+// Logging
+//
+// Each tic is logged as:
+//   UINT32 tic, INT16 map, UINT32 world hash
+//   UINT32 object count, for each kind
+//   UINT32 number of entries
+//   entries: UINT8 kind, UINT32 index, UINT16 type, UINT16 field hashes
+// where the entries are the objects that changed since the last tic.
+// A new map logs every object again.
+//
+
+void D_LogDesyncTic(void)
+{
+	desyncworld_t *swap;
+	UINT8 *p, *numentries_p;
+	UINT32 numentries = 0;
+	size_t needed = 4 + 2 + 4 + 4*NUMDESYNCKINDS + 4;
+	boolean newmap;
+	INT32 kind;
+	UINT32 i;
+
+	if (!logfile || gamestate != GS_LEVEL)
+		return;
+
+	newmap = (gamemap != loggedmap || levelstarttic != loggedlevelstart);
+	loggedmap = gamemap;
+	loggedlevelstart = levelstarttic;
+
+	HashWorld(current);
+
+	for (kind = 0; kind < NUMDESYNCKINDS; kind++)
+		needed += current->count[kind] * (1 + 4 + 2 + numfields[kind] * 2);
+
+	if (needed > recordsize)
+	{
+		recordsize = needed * 2;
+		record = Z_Realloc(record, recordsize, PU_STATIC, NULL);
+	}
+
+	p = record;
+	WRITEUINT32(p, gametic);
+	WRITEINT16(p, gamemap);
+	WRITEUINT32(p, WorldHash(current));
+	for (kind = 0; kind < NUMDESYNCKINDS; kind++)
+		WRITEUINT32(p, current->count[kind]);
+	numentries_p = p;
+	p += 4;
+
+	for (kind = 0; kind < NUMDESYNCKINDS; kind++)
+	{
+		for (i = 0; i < current->count[kind]; i++)
+		{
+			const desyncobject_t *obj = &current->objects[kind][i];
+			UINT8 f;
+
+			if (!newmap && i < previous->count[kind] && SameObject(obj, &previous->objects[kind][i], kind))
+				continue;
+
+			WRITEUINT8(p, kind);
+			WRITEUINT32(p, i);
+			WRITEUINT16(p, obj->type);
+			for (f = 0; f < numfields[kind]; f++)
+				WRITEUINT16(p, obj->fields[f]);
+			numentries++;
+		}
+	}
+
+	WRITEUINT32(numentries_p, numentries);
+
+	if (fwrite(record, 1, p - record, logfile) != (size_t)(p - record))
+	{
+		CONS_Alert(CONS_ERROR, M_GetText("Couldn't write the desync log, stopping it.\n"));
+		D_StopDesyncLog();
+		return;
+	}
+
+	swap = previous;
+	previous = current;
+	current = swap;
+}
+
+void D_StopDesyncLog(void)
+{
+	INT32 kind, w;
+
+	if (logfile)
+		fclose(logfile);
+	logfile = NULL;
+	desynclogging = false;
+
+	for (w = 0; w < 2; w++)
+	{
+		for (kind = 0; kind < NUMDESYNCKINDS; kind++)
+		{
+			Z_Free(worlds[w].objects[kind]);
+			worlds[w].objects[kind] = NULL;
+			worlds[w].count[kind] = worlds[w].max[kind] = 0;
+		}
+	}
+
+	Z_Free(record);
+	record = NULL;
+	recordsize = 0;
+}
+
+void Command_DesyncLog_f(void)
+{
+	const char *path;
+
+	if (COM_Argc() < 2)
+	{
+		if (logfile)
+		{
+			D_StopDesyncLog();
+			CONS_Printf(M_GetText("Stopped the desync log.\n"));
+		}
+		else
+			CONS_Printf(M_GetText("desynclog <file>: log world state hashes every tic, desynclog alone stops\n"));
+		return;
+	}
+
+	D_StopDesyncLog();
+
+	path = va(pandf, srb2home, COM_Argv(1));
+	logfile = fopen(path, "wb");
+	if (!logfile)
+	{
+		CONS_Alert(CONS_ERROR, M_GetText("Couldn't open %s\n"), path);
+		return;
+	}
+
+	fwrite(DESYNCLOGHEADER, 1, 8, logfile);
+	fputc(DESYNCLOGVERSION, logfile);
+
+	loggedmap = -1;
+	desynclogging = true;
+	CONS_Printf(M_GetText("Logging world state hashes to %s\n"), path);
+}
+
+//
+// Diffing
+//
+
+typedef struct
+{
+	UINT8 *buffer, *p, *end;
+	desyncworld_t world;
+	tic_t tic;
+	INT16 map;
+	UINT32 hash;
+} desyncreader_t;
+
+static boolean OpenDesyncLog(desyncreader_t *reader, const char *name)
+{
+	const char *path = va(pandf, srb2home, name);
+	size_t size;
+
+	memset(reader, 0, sizeof *reader);
+
+	size = FIL_ReadFile(path, &reader->buffer);
+	if (!size)
+	{
+		CONS_Alert(CONS_ERROR, M_GetText("Couldn't read %s\n"), path);
+		return false;
+	}
+
+	if (size < 9 || memcmp(reader->buffer, DESYNCLOGHEADER, 8) || reader->buffer[8] != DESYNCLOGVERSION)
+	{
+		CONS_Alert(CONS_ERROR, M_GetText("%s is not a desync log\n"), path);
+		Z_Free(reader->buffer);
+		return false;
+	}
+
+	reader->p = reader->buffer + 9;
+	reader->end = reader->buffer + size;
+	return true;
+}
+
+static void CloseDesyncLog(desyncreader_t *reader)
+{
+	INT32 kind;
+
+	for (kind = 0; kind < NUMDESYNCKINDS; kind++)
+		Z_Free(reader->world.objects[kind]);
+	Z_Free(reader->buffer);
+}
+
+// Reads the next tic and applies its changes. Returns false at the end.
+static boolean ReadDesyncTic(desyncreader_t *reader)
+{
+	UINT8 *p = reader->p;
+	UINT32 numentries;
+	INT32 kind;
+
+	if ((size_t)(reader->end - p) < 4 + 2 + 4 + 4*NUMDESYNCKINDS + 4)
+		return false;
+
+	reader->tic = READUINT32(p);
+	reader->map = READINT16(p);
+	reader->hash = READUINT32(p);
+	for (kind = 0; kind < NUMDESYNCKINDS; kind++)
+		reader->world.count[kind] = READUINT32(p);
+	numentries = READUINT32(p);
+
+	while (numentries--)
+	{
+		desyncobject_t *obj;
+		UINT32 index;
+		UINT8 f;
+
+		if (p >= reader->end)
+			return false;
+
+		kind = READUINT8(p);
+		if (kind >= NUMDESYNCKINDS || (size_t)(reader->end - p) < 4 + 2 + numfields[kind] * 2u)
+			return false;
+
+		index = READUINT32(p);
+		if (index >= reader->world.count[kind])
+			return false;
+
+		obj = WorldObject(&reader->world, kind, index);
+		obj->type = READUINT16(p);
+		for (f = 0; f < numfields[kind]; f++)
+			obj->fields[f] = READUINT16(p);
+	}
+
+	// Every object counted must have been logged by now
+	for (kind = 0; kind < NUMDESYNCKINDS; kind++)
+		if (reader->world.count[kind] > reader->world.max[kind])
+			return false;
+
+	reader->p = p;
+	return true;
+}
+
+static void ObjectTypeName(desynckind_t kind, UINT16 type, char *name, size_t size)
+{
+	if (kind != DK_MOBJ)
+		snprintf(name, size, "%s %d", kind == DK_SECTOR ? "special" : "id", type);
+	else if (type >= MT_FIRSTFREESLOT && type < NUMMOBJTYPES && FREE_MOBJS[type - MT_FIRSTFREESLOT])
+		snprintf(name, size, "MT_%s", FREE_MOBJS[type - MT_FIRSTFREESLOT]);
+	else if (type < MT_FIRSTFREESLOT)
+		snprintf(name, size, "%s", MOBJTYPE_LIST[type]);
+	else
+		snprintf(name, size, "mobjtype %d", type);
+}
+
+static void PrintDivergence(const desyncreader_t *a, const desyncreader_t *b)
+{
+	INT32 kind;
+	UINT32 i;
+
+	CONS_Printf(M_GetText("First divergence at tic %u, map %d\n"), a->tic, a->map);
+
+	for (kind = 0; kind < NUMDESYNCKINDS; kind++)
+	{
+		const UINT32 count = min(a->world.count[kind], b->world.count[kind]);
+
+		for (i = 0; i < count; i++)
+		{
+			const desyncobject_t *oa = &a->world.objects[kind][i];
+			const desyncobject_t *ob = &b->world.objects[kind][i];
+			char fields[256] = "";
+			char typea[64], typeb[64];
+			UINT8 f;
+
+			if (SameObject(oa, ob, kind))
+				continue;
+
+			ObjectTypeName(kind, oa->type, typea, sizeof typea);
+			ObjectTypeName(kind, ob->type, typeb, sizeof typeb);
+
+			if (oa->type != ob->type)
+			{
+				CONS_Printf(M_GetText("%s %u is %s in one log and %s in the other\n"),
+					kindnames[kind], i, typea, typeb);
+				return;
+			}
+
+			for (f = 0; f < numfields[kind]; f++)
+			{
+				if (oa->fields[f] == ob->fields[f])
+					continue;
+				if (fields[0])
+					strlcat(fields, ", ", sizeof fields);
+				strlcat(fields, fieldnames[kind][f], sizeof fields);
+			}
+
+			CONS_Printf(M_GetText("%s %u (%s) differs in: %s\n"),
+				kindnames[kind], i, typea, fields);
+			return;
+		}
+
+		if (a->world.count[kind] != b->world.count[kind])
+		{
+			CONS_Printf(M_GetText("One log has %u %ss, the other %u\n"),
+				a->world.count[kind], kindnames[kind], b->world.count[kind]);
+			return;
+		}
+	}
+
+	CONS_Printf(M_GetText("The world hashes differ, but no object does\n"));
+}
+
+void Command_DesyncDiff_f(void)
+{
+	desyncreader_t a, b;
+	boolean more;
+	UINT32 common = 0;
+
+	if (COM_Argc() < 3)
+	{
+		CONS_Printf(M_GetText("desyncdiff <log> <log>: find the first object that differs between two desync logs\n"));
+		return;
+	}
+
+	if (!OpenDesyncLog(&a, COM_Argv(1)))
+		return;
+	if (!OpenDesyncLog(&b, COM_Argv(2)))
+	{
+		CloseDesyncLog(&a);
+		return;
+	}
+
+	// The logs may not start on the same tic, but they still have to
+	// be replayed from their own start to know the state of every object
+	more = ReadDesyncTic(&a) && ReadDesyncTic(&b);
+	while (more)
+	{
+		if (a.tic < b.tic)
+			more = ReadDesyncTic(&a);
+		else if (b.tic < a.tic)
+			more = ReadDesyncTic(&b);
+		else if (a.hash != b.hash || a.map != b.map)
+		{
+			PrintDivergence(&a, &b);
+			break;
+		}
+		else
+		{
+			common++;
+			more = ReadDesyncTic(&a) && ReadDesyncTic(&b);
+		}
+	}
+
+	if (!more)
+		CONS_Printf(M_GetText("No divergence in %u common tics\n"), common);
+
+	CloseDesyncLog(&a);
+	CloseDesyncLog(&b);
+}
@@ -0,0 +1,25 @@
+// SONIC ROBO BLAST 2
+//-----------------------------------------------------------------------------
+// Copyright (C) 2024 by Sonic Team Junior.
+//
+// This program is free software distributed under the
+// terms of the GNU General Public License, version 2.
+// See the 'LICENSE' file for more details.
+//-----------------------------------------------------------------------------
+/// \file  desync_log.h
+/// \brief Per-tic world state hashes, for finding where a desync started
+
+#ifndef __DESYNC_LOG__
+#define __DESYNC_LOG__
+
+#include "../doomtype.h"
+
+extern boolean desynclogging;
+
+void D_LogDesyncTic(void);
+void D_StopDesyncLog(void);
+
+void Command_DesyncLog_f(void);
+void Command_DesyncDiff_f(void);
+
+#endif
@@ -26,7 +26,7 @@ packet versions.
 If you change the struct or the meaning of a field
 therein, increment this number.
 */
-#define PACKETVERSION 5
+#define PACKETVERSION 6
 
 // Network play related stuff.
 // There is a data struct that stores network
@@ -130,6 +130,7 @@ typedef struct
 	tic_t starttic;
 	UINT8 numtics;
 	UINT8 numslots; // "Slots filled": Highest player number in use plus one.
+	UINT8 packed; // Cmds are delta packed rather than raw ticcmd_t
 	ticcmd_t cmds[45];
 } ATTRPACK servertics_pak;
 
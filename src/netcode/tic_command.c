@@ -60,6 +60,197 @@ static inline void *G_ScpyTiccmd(ticcmd_t* dest, void* src, const size_t n)
 	return ret+n;
 }
 
+// Fields present in a packed ticcmd, see SV_PackTiccmd.
+// Only the fields carried by G_MoveTiccmd are sent.
+#define TCF_FORWARDMOVE 0x01
+#define TCF_SIDEMOVE    0x02
+#define TCF_ANGLETURN   0x04
+#define TCF_AIMING      0x08
+#define TCF_BUTTONS     0x10
+#define TCF_LATENCY     0x20
+
+// A packed ticcmd is at most one mask byte, two 3-byte deltas
+// and 5 more bytes of fields, one more than a raw ticcmd_t.
+// SV_SendTics falls back to raw ticcmds when packing does not pay off,
+// which is what keeps the packet within its raw size bound.
+#define MAXPACKEDTICCMDSIZE 12
+
+static UINT8 *WriteDelta16(UINT8 *p, INT16 delta)
+{
+	// Zigzag so small negative deltas stay small, then 7 bits per byte
+	UINT16 z = (UINT16)(((UINT16)delta << 1) ^ (delta < 0 ? 0xFFFF : 0));
+
+	while (z >= 0x80)
+	{
+		WRITEUINT8(p, (z & 0x7F) | 0x80);
+		z >>= 7;
+	}
+	WRITEUINT8(p, z);
+	return p;
+}
+
+static UINT8 *ReadDelta16(UINT8 *p, INT16 *delta)
+{
+	UINT16 z = 0;
+	UINT8 byte;
+	INT32 shift = 0;
+
+	do
+	{
+		byte = READUINT8(p);
+		z |= (UINT16)((byte & 0x7F) << shift);
+		shift += 7;
+	} while ((byte & 0x80) && shift < 21);
+
+	*delta = (INT16)((z >> 1) ^ (z & 1 ? 0xFFFF : 0));
+	return p;
+}
+
+/** Writes a ticcmd as the difference from the same slot's ticcmd
+  * on the previous tic of the packet
+  *
+  * \param p Where to write
+  * \param cmd The ticcmd to send
+  * \param ref The previous ticcmd, updated to cmd
+  * \return The position after the packed ticcmd
+  *
+  */
+static UINT8 *SV_PackTiccmd(UINT8 *p, const ticcmd_t *cmd, ticcmd_t *ref)
+{
+	UINT8 *maskp = p++;
+	UINT8 mask = 0;
+
+	if (cmd->forwardmove != ref->forwardmove)
+	{
+		mask |= TCF_FORWARDMOVE;
+		WRITESINT8(p, cmd->forwardmove);
+	}
+	if (cmd->sidemove != ref->sidemove)
+	{
+		mask |= TCF_SIDEMOVE;
+		WRITESINT8(p, cmd->sidemove);
+	}
+	if (cmd->angleturn != ref->angleturn)
+	{
+		mask |= TCF_ANGLETURN;
+		p = WriteDelta16(p, (INT16)(cmd->angleturn - ref->angleturn));
+	}
+	if (cmd->aiming != ref->aiming)
+	{
+		mask |= TCF_AIMING;
+		p = WriteDelta16(p, (INT16)(cmd->aiming - ref->aiming));
+	}
+	if (cmd->buttons != ref->buttons)
+	{
+		mask |= TCF_BUTTONS;
+		WRITEUINT16(p, cmd->buttons);
+	}
+	if (cmd->latency != ref->latency)
+	{
+		mask |= TCF_LATENCY;
+		WRITEUINT8(p, cmd->latency);
+	}
+
+	*maskp = mask;
+	*ref = *cmd;
+	return p;
+}
+
+static UINT8 *CL_UnpackTiccmd(UINT8 *p, ticcmd_t *ref)
+{
+	UINT8 mask = READUINT8(p);
+	INT16 delta;
+
+	if (mask & TCF_FORWARDMOVE)
+		ref->forwardmove = READSINT8(p);
+	if (mask & TCF_SIDEMOVE)
+		ref->sidemove = READSINT8(p);
+	if (mask & TCF_ANGLETURN)
+	{
+		p = ReadDelta16(p, &delta);
+		ref->angleturn = (INT16)(ref->angleturn + delta);
+	}
+	if (mask & TCF_AIMING)
+	{
+		p = ReadDelta16(p, &delta);
+		ref->aiming = (INT16)(ref->aiming + delta);
+	}
+	if (mask & TCF_BUTTONS)
+		ref->buttons = READUINT16(p);
+	if (mask & TCF_LATENCY)
+		ref->latency = READUINT8(p);
+
+	return p;
+}
+
+/** Steps over a packed ticcmd without decoding it
+  *
+  * \param p The start of the packed ticcmd
+  * \param end The end of the received data
+  * \return The position after the packed ticcmd, or NULL if it runs past end
+  *
+  */
+static const UINT8 *CL_SkipPackedTiccmd(const UINT8 *p, const UINT8 *end)
+{
+	UINT8 mask;
+
+	if (p >= end)
+		return NULL;
+	mask = *p++;
+
+	p += !!(mask & TCF_FORWARDMOVE) + !!(mask & TCF_SIDEMOVE);
+
+	for (UINT8 flag = TCF_ANGLETURN; flag <= TCF_AIMING; flag <<= 1)
+	{
+		INT32 shift = 0;
+
+		if (!(mask & flag))
+			continue;
+
+		// Same termination as ReadDelta16
+		do
+		{
+			if (p >= end)
+				return NULL;
+			shift += 7;
+		} while ((*p++ & 0x80) && shift < 21);
+	}
+
+	p += (mask & TCF_BUTTONS ? 2 : 0) + !!(mask & TCF_LATENCY);
+
+	return p <= end ? p : NULL;
+}
+
+/** Checks that the net commands of a server packet fit in the received data
+  *
+  * \param p The start of the net commands
+  * \param end The end of the received data
+  * \param numtics The number of tics to check the net commands of
+  * \return True if every net command is whole and for a valid player
+  *
+  */
+static boolean CL_NetCommandsFit(const UINT8 *p, const UINT8 *end, tic_t numtics)
+{
+	for (tic_t i = 0; i < numtics; i++)
+	{
+		UINT8 numcmds;
+
+		if (p >= end)
+			return false;
+		numcmds = *p++;
+
+		for (UINT32 j = 0; j < numcmds; j++)
+		{
+			// playernum, then the size byte and that many bytes
+			if (end - p < 2 || p[0] >= MAXPLAYERS || end - p < 2 + p[1])
+				return false;
+			p += 2 + p[1];
+		}
+	}
+
+	return true;
+}
+
 /** Guesses the full value of a tic from its lowest byte, for a specific node
   *
   * \param low The lowest byte of the tic value
@@ -245,22 +436,77 @@ void PT_ServerTics(SINT8 node, INT32 netconsole)
 	realend = min(realend, gametic + CLIENTBACKUPTICS);
 	cl_packetmissed = realstart > neededtic;
 
+	if (packet->numslots > MAXPLAYERS)
+	{
+		DEBFILE(va("bad slot count %d in PT_SERVERTICS\n", packet->numslots));
+		return;
+	}
+
 	if (realstart <= neededtic && realend > neededtic)
 	{
 		UINT8 *pak = (UINT8 *)&packet->cmds;
-		UINT8 *txtpak = (UINT8 *)&packet->cmds[packet->numslots * packet->numtics];
+		const UINT8 *end = (UINT8 *)netbuffer + doomcom->datalength;
+		const UINT8 *txtend;
+		UINT8 *txtpak;
 
-		for (tic_t i = realstart; i < realend; i++)
+		// Check the whole packet before touching any tic,
+		// so a bad one cannot leave them half cleared
+		if (packet->packed)
+		{
+			txtend = pak;
+			for (INT32 j = packet->numtics * packet->numslots; j > 0 && txtend; j--)
+				txtend = CL_SkipPackedTiccmd(txtend, end);
+		}
+		else
 		{
-			// clear first
-			D_Clearticcmd(i);
+			txtend = (UINT8 *)&packet->cmds[packet->numslots * packet->numtics];
+			if (txtend > end)
+				txtend = NULL;
+		}
 
-			// copy the tics
-			pak = G_ScpyTiccmd(netcmds[i%BACKUPTICS], pak,
-				packet->numslots*sizeof (ticcmd_t));
+		if (!txtend || !CL_NetCommandsFit(txtend, end, realend - realstart))
+		{
+			DEBFILE(va("truncated PT_SERVERTICS from node %d\n", node));
+			return;
+		}
 
-			CL_CopyNetCommandsFromServerPacket(i, &txtpak);
+		if (packet->packed)
+		{
+			// Every tic is relative to the one before it,
+			// so all of them must be walked to find the net commands
+			ticcmd_t ref[MAXPLAYERS];
+			memset(ref, 0, sizeof (ref));
+
+			for (tic_t i = realstart; i < realstart + packet->numtics; i++)
+			{
+				for (INT32 j = 0; j < packet->numslots; j++)
+					pak = CL_UnpackTiccmd(pak, &ref[j]);
+
+				if (i < realend)
+				{
+					D_Clearticcmd(i);
+					M_Memcpy(netcmds[i%BACKUPTICS], ref, packet->numslots * sizeof (ticcmd_t));
+				}
+			}
+			txtpak = pak;
 		}
+		else
+		{
+			txtpak = (UINT8 *)&packet->cmds[packet->numslots * packet->numtics];
+
+			for (tic_t i = realstart; i < realend; i++)
+			{
+				// clear first
+				D_Clearticcmd(i);
+
+				// copy the tics
+				pak = G_ScpyTiccmd(netcmds[i%BACKUPTICS], pak,
+					packet->numslots*sizeof (ticcmd_t));
+			}
+		}
+
+		for (tic_t i = realstart; i < realend; i++)
+			CL_CopyNetCommandsFromServerPacket(i, &txtpak);
 
 		neededtic = realend;
 	}
@@ -321,10 +567,17 @@ void CL_SendClientCmd(void)
 static tic_t SV_CalculateNumTicsForPacket(SINT8 nodenum, tic_t firsttic, tic_t lasttic)
 {
 	size_t size = BASESERVERTICSSIZE;
+	ticcmd_t ref[MAXPLAYERS];
+	UINT8 scratch[MAXPACKEDTICCMDSIZE * MAXPLAYERS];
+
+	memset(ref, 0, sizeof (ref));
 
 	for (tic_t tic = firsttic; tic < lasttic; tic++)
 	{
-		size += sizeof (ticcmd_t) * doomcom->numslots;
+		UINT8 *p = scratch;
+		for (INT32 i = 0; i < doomcom->numslots; i++)
+			p = SV_PackTiccmd(p, &netcmds[tic%BACKUPTICS][i], &ref[i]);
+		size += p - scratch;
 		size += TotalTextCmdPerTic(tic);
 
 		if (size > software_MAXPACKETLENGTH)
@@ -400,10 +653,23 @@ void SV_SendTics(void)
 			netbuffer->u.serverpak.numtics = (UINT8)(lasttictosend - realfirsttic);
 			netbuffer->u.serverpak.numslots = (UINT8)SHORT(doomcom->numslots);
 
-			// Fill and send the packet
+			// Fill and send the packet, delta packing the ticcmds
+			// unless that would not be any smaller for this node
 			UINT8 *bufpos = (UINT8 *)&netbuffer->u.serverpak.cmds;
+			ticcmd_t ref[MAXPLAYERS];
+			memset(ref, 0, sizeof (ref));
 			for (tic_t i = realfirsttic; i < lasttictosend; i++)
-				bufpos = G_DcpyTiccmd(bufpos, netcmds[i%BACKUPTICS], doomcom->numslots * sizeof (ticcmd_t));
+				for (INT32 j = 0; j < doomcom->numslots; j++)
+					bufpos = SV_PackTiccmd(bufpos, &netcmds[i%BACKUPTICS][j], &ref[j]);
+
+			const size_t rawsize = (lasttictosend - realfirsttic) * doomcom->numslots * sizeof (ticcmd_t);
+			netbuffer->u.serverpak.packed = ((size_t)(bufpos - (UINT8 *)&netbuffer->u.serverpak.cmds) < rawsize);
+			if (!netbuffer->u.serverpak.packed)
+			{
+				bufpos = (UINT8 *)&netbuffer->u.serverpak.cmds;
+				for (tic_t i = realfirsttic; i < lasttictosend; i++)
+					bufpos = G_DcpyTiccmd(bufpos, netcmds[i%BACKUPTICS], doomcom->numslots * sizeof (ticcmd_t));
+			}
 			for (tic_t i = realfirsttic; i < lasttictosend; i++)
 				SV_WriteNetCommandsForTic(i, &bufpos);
 			size_t packsize = bufpos - (UINT8 *)&(netbuffer->u);
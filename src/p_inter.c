@@ -404,7 +404,8 @@ void P_TouchSpecialThing(mobj_t *special, mobj_t *toucher, boolean heightcheck)
 			return;
 
 		// Some hooks may assume that the toucher is a player, so we keep it in here.
-		if (LUA_HookTouchSpecial(special, toucher) || P_MobjWasRemoved(special))
+		if (LUA_HasMobjHook(special, TouchSpecial)
+			&& (LUA_HookTouchSpecial(special, toucher) || P_MobjWasRemoved(special)))
 			return;
 	}
 
@@ -968,6 +968,7 @@ static unsigned PIT_DoCheckThing(mobj_t *thing)
 			return CHECKTHING_NOCOLLIDE; // the line doesn't cross between either pair of opposite corners
 	}
 
+	if (LUA_HasMobjHook(thing, MobjCollide) || LUA_HasMobjHook(tmthing, MobjMoveCollide))
 	{
 		UINT8 shouldCollide = LUA_Hook2Mobj(thing, tmthing, MOBJ_HOOK(MobjCollide)); // checks hook for thing's type
 		if (P_MobjWasRemoved(tmthing) || P_MobjWasRemoved(thing))
@@ -1979,6 +1980,7 @@ static boolean PIT_CheckLine(line_t *ld)
 	// this line is out of the if so upper and lower textures can be hit by a splat
 	blockingline = ld;
 
+	if (LUA_HasMobjHook(tmthing, MobjLineCollide))
 	{
 		UINT8 shouldCollide = LUA_HookMobjLineCollide(tmthing, blockingline); // checks hook for thing's type
 		if (P_MobjWasRemoved(tmthing))
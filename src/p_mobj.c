@@ -7516,7 +7516,7 @@ static void P_RosySceneryThink(mobj_t *mobj)
 
 static void P_MobjSceneryThink(mobj_t *mobj)
 {
-	if (LUA_HookMobj(mobj, MOBJ_HOOK(MobjThinker)))
+	if (LUA_HasMobjHook(mobj, MobjThinker) && LUA_HookMobj(mobj, MOBJ_HOOK(MobjThinker)))
 		return;
 	if (P_MobjWasRemoved(mobj))
 		return;
@@ -7964,7 +7964,7 @@ static boolean P_MobjPushableThink(mobj_t *mobj)
 
 static boolean P_MobjBossThink(mobj_t *mobj)
 {
-	if (LUA_HookMobj(mobj, MOBJ_HOOK(BossThinker)))
+	if (LUA_HasMobjHook(mobj, BossThinker) && LUA_HookMobj(mobj, MOBJ_HOOK(BossThinker)))
 	{
 		if (P_MobjWasRemoved(mobj))
 			return false;
@@ -10212,15 +10212,19 @@ void P_MobjThinker(mobj_t *mobj)
 	// Check for a Lua thinker first
 	if (!mobj->player)
 	{
-		if (LUA_HookMobj(mobj, MOBJ_HOOK(MobjThinker)) || P_MobjWasRemoved(mobj))
+		if (LUA_HasMobjHook(mobj, MobjThinker)
+			&& (LUA_HookMobj(mobj, MOBJ_HOOK(MobjThinker)) || P_MobjWasRemoved(mobj)))
 			return;
 	}
 	else if (!mobj->player->spectator)
 	{
 		// You cannot short-circuit the player thinker like you can other thinkers.
-		LUA_HookMobj(mobj, MOBJ_HOOK(MobjThinker));
-		if (P_MobjWasRemoved(mobj))
-			return;
+		if (LUA_HasMobjHook(mobj, MobjThinker))
+		{
+			LUA_HookMobj(mobj, MOBJ_HOOK(MobjThinker));
+			if (P_MobjWasRemoved(mobj))
+				return;
+		}
 	}
 
 	// if it's pushable, or if it would be pushable other than temporary disablement, use the
@@ -10774,7 +10778,7 @@ mobj_t *P_SpawnMobj(fixed_t x, fixed_t y, fixed_t z, mobjtype_t type, ...)
 
 	// DANGER! This can cause P_SpawnMobj to return NULL!
 	// Avoid using P_RemoveMobj on the newly created mobj in "MobjSpawn" Lua hooks!
-	status = LUA_HookMobj(mobj, MOBJ_HOOK(MobjSpawn));
+	status = LUA_HasMobjHook(mobj, MobjSpawn) && LUA_HookMobj(mobj, MOBJ_HOOK(MobjSpawn));
 	mobj->thinker.references--;
 
 	if (status)
@@ -11202,7 +11206,8 @@ void P_RemoveMobj(mobj_t *mobj)
 		return; // something already removing this mobj.
 
 	mobj->thinker.function.acp1 = (actionf_p1)P_RemoveThinkerDelayed; // shh. no recursing.
-	LUA_HookMobj(mobj, MOBJ_HOOK(MobjRemoved));
+	if (LUA_HasMobjHook(mobj, MobjRemoved))
+		LUA_HookMobj(mobj, MOBJ_HOOK(MobjRemoved));
 	mobj->thinker.function.acp1 = (actionf_p1)P_MobjThinker; // needed for P_UnsetThingPosition, etc. to work.
 
 	// Rings only, please!
@@ -38,6 +38,29 @@
 
 savedata_t savedata;
 UINT8 *save_p;
+UINT8 *save_end = NULL;
+static boolean save_full = false;
+
+/** Checks if P_SaveNetGame has to stop writing, because save_end is set
+  * and fewer than SAVEBUFFERMARGIN + extra bytes are left before it.
+  * The checks are made between bounded chunks of data, each smaller than
+  * the margin.
+  *
+  * Unbounded saves, with save_end NULL, are never full, even if the
+  * last bounded one was cut short.
+  *
+  * \param extra Bytes to reserve on top of the margin.
+  * \return true if the save was cut short.
+  */
+boolean P_SaveBufferFull(size_t extra)
+{
+	if (!save_end)
+		return false;
+	if (!save_full
+		&& (save_p > save_end || (size_t)(save_end - save_p) < SAVEBUFFERMARGIN + extra))
+		save_full = true;
+	return save_full;
+}
 
 // Block UINT32s to attempt to ensure that the correct data is
 // being sent and received
@@ -682,16 +705,20 @@ static void P_NetArchiveColormaps(void)
 		if (!exc)
 			exc = R_CreateDefaultColormap(false);
 
-		WRITEUINT8(save_p, exc->fadestart);
-		WRITEUINT8(save_p, exc->fadeend);
-		WRITEUINT8(save_p, exc->flags);
+		// The list is freed either way
+		if (!P_SaveBufferFull(0))
+		{
+			WRITEUINT8(save_p, exc->fadestart);
+			WRITEUINT8(save_p, exc->fadeend);
+			WRITEUINT8(save_p, exc->flags);
 
-		WRITEINT32(save_p, exc->rgba);
-		WRITEINT32(save_p, exc->fadergba);
+			WRITEINT32(save_p, exc->rgba);
+			WRITEINT32(save_p, exc->fadergba);
 
 #ifdef EXTRACOLORMAPLUMPS
-		WRITESTRINGN(save_p, exc->lumpname, 9);
+			WRITESTRINGN(save_p, exc->lumpname, 9);
 #endif
+		}
 
 		exc_next = exc->next;
 		Z_Free(exc); // don't need anymore
@@ -810,6 +837,9 @@ static void P_NetArchiveWaypoints(void)
 
 	for (i = 0; i < NUMWAYPOINTSEQUENCES; i++)
 	{
+		if (P_SaveBufferFull(0))
+			return;
+
 		WRITEUINT16(save_p, numwaypoints[i]);
 		for (j = 0; j < numwaypoints[i]; j++)
 			WRITEUINT32(save_p, waypoints[i][j] ? waypoints[i][j]->mobjnum : 0);
@@ -1045,6 +1075,9 @@ static void ArchiveSectors(void)
 
 	for (i = 0; i < numsectors; i++, ss++, spawnss++)
 	{
+		if (P_SaveBufferFull(0))
+			return;
+
 		diff = diff2 = diff3 = diff4 = diff5 = 0;
 		if (ss->floorheight != spawnss->floorheight)
 			diff |= SD_FLOORHT;
@@ -1449,6 +1482,9 @@ static void ArchiveLines(void)
 
 	for (i = 0; i < numlines; i++, spawnli++, li++)
 	{
+		if (P_SaveBufferFull(0))
+			return;
+
 		diff = diff2 = 0;
 		side1diff = side2diff = 0;
 
@@ -2680,6 +2716,9 @@ static void P_NetArchiveThinkers(void)
 		// save off the current thinkers
 		for (th = thlist[i].next; th != &thlist[i]; th = th->next)
 		{
+			if (P_SaveBufferFull(0))
+				return;
+
 			if (!(th->function.acp1 == (actionf_p1)P_RemoveThinkerDelayed
 			 || th->function.acp1 == (actionf_p1)P_NullPrecipThinker))
 				numsaved++;
@@ -4944,6 +4983,9 @@ static void P_NetArchiveSectorPortals(void)
 	{
 		UINT8 type = secportals[i].type;
 
+		if (P_SaveBufferFull(0))
+			return;
+
 		WRITEUINT8(save_p, type);
 		WRITEFIXED(save_p, secportals[i].origin.x);
 		WRITEFIXED(save_p, secportals[i].origin.y);
@@ -5069,12 +5111,14 @@ void P_SaveGame(INT16 mapnum)
 	P_ArchiveLuabanksAndConsistency();
 }
 
-void P_SaveNetGame(boolean resending)
+boolean P_SaveNetGame(boolean resending)
 {
 	thinker_t *th;
 	mobj_t *mobj;
 	INT32 i = 1; // don't start from 0, it'd be confused with a blank pointer otherwise
 
+	save_full = false;
+
 	CV_SaveNetVars(&save_p);
 	P_NetArchiveMisc(resending);
 	P_NetArchiveEmblems();
@@ -5091,20 +5135,29 @@ void P_SaveNetGame(boolean resending)
 		mobj->mobjnum = i++;
 	}
 
-	P_NetArchivePlayers();
+	if (!P_SaveBufferFull(0))
+		P_NetArchivePlayers();
 	if (gamestate == GS_LEVEL)
 	{
+		// The world and colormaps are always archived, to clean up the
+		// colormap list they share
 		P_NetArchiveWorld();
-		P_ArchivePolyObjects();
+		if (!P_SaveBufferFull(0))
+			P_ArchivePolyObjects();
 		P_NetArchiveThinkers();
-		P_NetArchiveSpecials();
+		if (!P_SaveBufferFull(0))
+			P_NetArchiveSpecials();
 		P_NetArchiveColormaps();
 		P_NetArchiveWaypoints();
 		P_NetArchiveSectorPortals();
 	}
-	LUA_Archive();
+	if (!P_SaveBufferFull(0))
+		LUA_Archive();
 
-	P_ArchiveLuabanksAndConsistency();
+	if (!P_SaveBufferFull(0))
+		P_ArchiveLuabanksAndConsistency();
+
+	return !save_full;
 }
 
 boolean P_LoadGame(INT16 mapoverride)
@@ -5137,6 +5190,7 @@ boolean P_LoadNetGame(boolean reloading)
 	if (gamestate == GS_LEVEL)
 	{
 		P_NetUnArchiveWorld();
+		Taglist_InitLineSpecials(); // Line specials may have been changed
 		P_UnArchivePolyObjects();
 		P_NetUnArchiveThinkers();
 		P_NetUnArchiveSpecials();
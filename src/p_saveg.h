@@ -24,7 +24,7 @@
 // These are the load / save game routines.
 
 void P_SaveGame(INT16 mapnum);
-void P_SaveNetGame(boolean resending);
+boolean P_SaveNetGame(boolean resending);
 boolean P_LoadGame(INT16 mapoverride);
 boolean P_LoadNetGame(boolean reloading);
 
@@ -44,4 +44,10 @@ typedef struct
 extern savedata_t savedata;
 extern UINT8 *save_p;
 
+// If set, P_SaveNetGame stops writing before it can pass save_end,
+// and returns false
+extern UINT8 *save_end;
+#define SAVEBUFFERMARGIN (64*1024)
+boolean P_SaveBufferFull(size_t extra);
+
 #endif
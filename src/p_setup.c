@@ -7983,9 +7983,6 @@ boolean P_LoadLevel(boolean fromnetsave, boolean reloadinggamestate)
 
 	P_ClearBlockNodes();
 
-	// Clear pointers that would be left dangling by the purge
-	R_FlushTranslationColormapCache();
-
 #ifdef HWRENDER
 	// Free GPU textures before freeing patches.
 	if (rendermode == render_opengl && (vid.glstate == VID_GL_LIBRARY_LOADED))
@@ -8067,6 +8064,7 @@ boolean P_LoadLevel(boolean fromnetsave, boolean reloadinggamestate)
 
 	// set up world state
 	P_SpawnSpecials(fromnetsave);
+	Taglist_InitLineSpecials();
 
 	if (!fromnetsave) //  ugly hack for P_NetUnArchiveMisc (and P_LoadNetGame)
 		P_SpawnPrecipitation();
@@ -8107,6 +8105,9 @@ boolean P_LoadLevel(boolean fromnetsave, boolean reloadinggamestate)
 	if (precache || dedicated)
 		R_PrecacheLevel();
 
+	if (precache)
+		S_PrecacheLevelSounds();
+
 	nextmapoverride = 0;
 	skipstats = 0;
 
@@ -1154,13 +1154,10 @@ static boolean PolyRotDisplace(line_t *line)
 //
 void P_RunNightserizeExecutors(mobj_t *actor)
 {
-	size_t i;
+	INT32 i;
 
-	for (i = 0; i < numlines; i++)
-	{
-		if (lines[i].special == 323)
-			P_RunTriggerLinedef(&lines[i], actor, NULL);
-	}
+	SPECIAL_ITER_LINES(323, i)
+		P_RunTriggerLinedef(&lines[i], actor, NULL);
 }
 
 //
@@ -1168,13 +1165,10 @@ void P_RunNightserizeExecutors(mobj_t *actor)
 //
 void P_RunDeNightserizeExecutors(mobj_t *actor)
 {
-	size_t i;
+	INT32 i;
 
-	for (i = 0; i < numlines; i++)
-	{
-		if (lines[i].special == 325)
-			P_RunTriggerLinedef(&lines[i], actor, NULL);
-	}
+	SPECIAL_ITER_LINES(325, i)
+		P_RunTriggerLinedef(&lines[i], actor, NULL);
 }
 
 //
@@ -1182,13 +1176,10 @@ void P_RunDeNightserizeExecutors(mobj_t *actor)
 //
 void P_RunNightsLapExecutors(mobj_t *actor)
 {
-	size_t i;
+	INT32 i;
 
-	for (i = 0; i < numlines; i++)
-	{
-		if (lines[i].special == 327)
-			P_RunTriggerLinedef(&lines[i], actor, NULL);
-	}
+	SPECIAL_ITER_LINES(327, i)
+		P_RunTriggerLinedef(&lines[i], actor, NULL);
 }
 
 //
@@ -1196,13 +1187,10 @@ void P_RunNightsLapExecutors(mobj_t *actor)
 //
 void P_RunNightsCapsuleTouchExecutors(mobj_t *actor, boolean entering, boolean enoughspheres)
 {
-	size_t i;
+	INT32 i;
 
-	for (i = 0; i < numlines; i++)
+	SPECIAL_ITER_LINES(329, i)
 	{
-		if (lines[i].special != 329)
-			continue;
-
 		if (!!(lines[i].args[7] & TMI_ENTER) != entering)
 			continue;
 
@@ -708,14 +708,83 @@ static UINT8 LightTableNearest_LUT(UINT8 r, UINT8 g, UINT8 b)
 	return GetColorLUT(&lighttable_lut, r, g, b);
 }
 
+// Generated light tables, kept across levels since the same colormaps
+// come back in every map of an addon and while colormaps fade
+#define LIGHTTABLECACHESIZE 256
+#define LIGHTTABLESIZE (256 * 34)
+
+typedef struct
+{
+	boolean valid;
+	boolean uselookup;
+	INT32 rgba, fadergba;
+	UINT8 fadestart, fadeend;
+	lighttable_t *table;
+} lighttablecache_t;
+
+static lighttablecache_t lighttablecache[LIGHTTABLECACHESIZE];
+static RGBA_t lighttablecachepalette[256];
+
+static lighttablecache_t *R_GetLightTableCache(extracolormap_t *extra_colormap, boolean uselookup)
+{
+	UINT32 hash;
+
+	// Tables made from another palette are no use anymore
+	if (memcmp(lighttablecachepalette, pMasterPalette, sizeof (lighttablecachepalette)))
+	{
+		for (hash = 0; hash < LIGHTTABLECACHESIZE; hash++)
+			lighttablecache[hash].valid = false;
+		M_Memcpy(lighttablecachepalette, pMasterPalette, sizeof (lighttablecachepalette));
+	}
+
+	hash = (UINT32)extra_colormap->rgba * 0x9E3779B1u;
+	hash ^= (UINT32)extra_colormap->fadergba * 0x85EBCA6Bu;
+	hash ^= (extra_colormap->fadestart << 8 | extra_colormap->fadeend) * 0xC2B2AE35u;
+	hash ^= hash >> 16;
+
+	return &lighttablecache[(hash + uselookup) % LIGHTTABLECACHESIZE];
+}
+
+static boolean R_LightTableCacheMatches(lighttablecache_t *cache, extracolormap_t *extra_colormap, boolean uselookup)
+{
+	return cache->valid && cache->uselookup == uselookup
+		&& cache->rgba == extra_colormap->rgba && cache->fadergba == extra_colormap->fadergba
+		&& cache->fadestart == extra_colormap->fadestart && cache->fadeend == extra_colormap->fadeend;
+}
+
+static void R_BuildLightTable(extracolormap_t *extra_colormap, boolean uselookup);
+
 lighttable_t *R_CreateLightTable(extracolormap_t *extra_colormap)
 {
-	extra_colormap->colormap = Z_MallocAlign((256 * 34) + 10, PU_LEVEL, NULL, 8);
+	extra_colormap->colormap = Z_MallocAlign(LIGHTTABLESIZE + 10, PU_LEVEL, NULL, 8);
 	R_GenerateLightTable(extra_colormap, false);
 	return extra_colormap->colormap;
 }
 
 void R_GenerateLightTable(extracolormap_t *extra_colormap, boolean uselookup)
+{
+	lighttablecache_t *cache = R_GetLightTableCache(extra_colormap, uselookup);
+
+	if (R_LightTableCacheMatches(cache, extra_colormap, uselookup))
+	{
+		M_Memcpy(extra_colormap->colormap, cache->table, LIGHTTABLESIZE);
+		return;
+	}
+
+	R_BuildLightTable(extra_colormap, uselookup);
+
+	if (!cache->table)
+		cache->table = Z_Malloc(LIGHTTABLESIZE, PU_STATIC, NULL);
+	M_Memcpy(cache->table, extra_colormap->colormap, LIGHTTABLESIZE);
+	cache->valid = true;
+	cache->uselookup = uselookup;
+	cache->rgba = extra_colormap->rgba;
+	cache->fadergba = extra_colormap->fadergba;
+	cache->fadestart = extra_colormap->fadestart;
+	cache->fadeend = extra_colormap->fadeend;
+}
+
+static void R_BuildLightTable(extracolormap_t *extra_colormap, boolean uselookup)
 {
 	double cmaskr, cmaskg, cmaskb, cdestr, cdestg, cdestb;
 	double maskamt = 0, othermask = 0;
@@ -1138,8 +1207,8 @@ UINT8 NearestPaletteColor(UINT8 r, UINT8 g, UINT8 b, RGBA_t *palette)
 	int distortion, bestdistortion = 256 * 256 * 4, bestcolor = 0, i;
 
 	// Use master palette if none specified
-	if (palette == NULL)
-		palette = pMasterPalette;
+	if (palette == NULL || palette == pMasterPalette)
+		return V_NearestMasterPaletteColor(r, g, b);
 
 	for (i = 0; i < 256; i++)
 	{
@@ -580,32 +580,50 @@ UINT8* R_GetTranslationColormap(INT32 skinnum, skincolornum_t color, UINT8 flags
 	// Generate the colormap if necessary
 	if (!ret)
 	{
-		ret = Z_Malloc(sizeof(colorcache_t), (flags & GTC_CACHE) ? PU_LEVEL : PU_STATIC, NULL);
+		// Cached colormaps are kept across levels, until the skins change
+		ret = Z_Malloc(sizeof(colorcache_t), PU_STATIC, NULL);
 		R_GenerateTranslationColormap(ret->colors, skinnum, color, starttranscolor);
 
 		// Cache the colormap if desired
 		if (flags & GTC_CACHE)
+		{
 			translationtablecache[index][color] = ret;
+			ps_numtranslationmisses.value.i++;
+		}
 	}
+	else
+		ps_numtranslationhits.value.i++;
 
 	return ret->colors;
 }
 
 /**	\brief	Flushes cache of translation colormaps.
 
-	Flushes cache of translation colormaps, but doesn't actually free the
-	colormaps themselves. These are freed when PU_LEVEL blocks are purged,
-	at or before which point, this function should be called.
+	Empties the cache of translation colormaps. The cache survives level
+	changes, so this only needs to be called when skins are added or
+	changed, since that can change their start colors. Colormaps already
+	handed out stay valid until the end of the level.
 
 	\return	void
 */
 void R_FlushTranslationColormapCache(void)
 {
-	INT32 i;
+	INT32 i, j;
 
 	for (i = 0; i < TT_CACHE_SIZE; i++)
-		if (translationtablecache[i])
-			memset(translationtablecache[i], 0, MAXSKINCOLORS * sizeof(UINT8**));
+	{
+		if (!translationtablecache[i])
+			continue;
+
+		for (j = 0; j < MAXSKINCOLORS; j++)
+		{
+			if (translationtablecache[i][j])
+			{
+				Z_ChangeTag(translationtablecache[i][j], PU_LEVEL);
+				translationtablecache[i][j] = NULL;
+			}
+		}
+	}
 }
 
 UINT16 R_GetColorByName(const char *name)
@@ -330,7 +330,11 @@ void R_InterpolateMobjState(mobj_t *mobj, fixed_t frac, interpmobjstate_t *out)
 	out->spritexoffset = mobj->spritexoffset;
 	out->spriteyoffset = mobj->spriteyoffset;
 
-	out->subsector = R_PointInSubsector(out->x, out->y);
+	// Most things don't move horizontally, skip the BSP walk for them
+	if (mobj->subsector && mobj->old_x == mobj->x && mobj->old_y == mobj->y)
+		out->subsector = mobj->subsector;
+	else
+		out->subsector = R_PointInSubsector(out->x, out->y);
 
 	if (mobj->player)
 	{
@@ -379,7 +383,11 @@ void R_InterpolatePrecipMobjState(precipmobj_t *mobj, fixed_t frac, interpmobjst
 	out->spritexoffset = R_LerpFixed(mobj->old_spritexoffset, mobj->spritexoffset, frac);
 	out->spriteyoffset = R_LerpFixed(mobj->old_spriteyoffset, mobj->spriteyoffset, frac);
 
-	out->subsector = R_PointInSubsector(out->x, out->y);
+	// Precipitation only falls, so this is nearly always the same subsector
+	if (mobj->subsector && mobj->old_x == mobj->x && mobj->old_y == mobj->y)
+		out->subsector = mobj->subsector;
+	else
+		out->subsector = R_PointInSubsector(out->x, out->y);
 
 	out->angle = R_LerpAngle(mobj->old_angle, mobj->angle, frac);
 	out->pitch = R_LerpAngle(mobj->old_pitch, mobj->pitch, frac);
@@ -524,34 +532,49 @@ static void UpdateLevelInterpolatorState(levelinterpolator_t *interp)
 	case LVLINTERP_SectorPlane:
 		interp->sectorplane.oldheight = interp->sectorplane.bakheight;
 		interp->sectorplane.bakheight = interp->sectorplane.ceiling ? interp->sectorplane.sector->ceilingheight : interp->sectorplane.sector->floorheight;
+		interp->changed = (interp->sectorplane.oldheight != interp->sectorplane.bakheight);
 		break;
 	case LVLINTERP_SectorScroll:
 		interp->sectorscroll.oldxoffs = interp->sectorscroll.bakxoffs;
 		interp->sectorscroll.bakxoffs = interp->sectorscroll.ceiling ? interp->sectorscroll.sector->ceilingxoffset : interp->sectorscroll.sector->floorxoffset;
 		interp->sectorscroll.oldyoffs = interp->sectorscroll.bakyoffs;
 		interp->sectorscroll.bakyoffs = interp->sectorscroll.ceiling ? interp->sectorscroll.sector->ceilingyoffset : interp->sectorscroll.sector->flooryoffset;
+		interp->changed = (interp->sectorscroll.oldxoffs != interp->sectorscroll.bakxoffs
+			|| interp->sectorscroll.oldyoffs != interp->sectorscroll.bakyoffs);
 		break;
 	case LVLINTERP_SideScroll:
 		interp->sidescroll.oldtextureoffset = interp->sidescroll.baktextureoffset;
 		interp->sidescroll.baktextureoffset = interp->sidescroll.side->textureoffset;
 		interp->sidescroll.oldrowoffset = interp->sidescroll.bakrowoffset;
 		interp->sidescroll.bakrowoffset = interp->sidescroll.side->rowoffset;
+		interp->changed = (interp->sidescroll.oldtextureoffset != interp->sidescroll.baktextureoffset
+			|| interp->sidescroll.oldrowoffset != interp->sidescroll.bakrowoffset);
 		break;
 	case LVLINTERP_Polyobj:
+		interp->changed = false;
 		for (i = 0; i < interp->polyobj.vertices_size; i++)
 		{
 			interp->polyobj.oldvertices[i * 2    ] = interp->polyobj.bakvertices[i * 2    ];
 			interp->polyobj.oldvertices[i * 2 + 1] = interp->polyobj.bakvertices[i * 2 + 1];
 			interp->polyobj.bakvertices[i * 2    ] = interp->polyobj.polyobj->vertices[i]->x;
 			interp->polyobj.bakvertices[i * 2 + 1] = interp->polyobj.polyobj->vertices[i]->y;
+			if (interp->polyobj.oldvertices[i * 2    ] != interp->polyobj.bakvertices[i * 2    ]
+				|| interp->polyobj.oldvertices[i * 2 + 1] != interp->polyobj.bakvertices[i * 2 + 1])
+				interp->changed = true;
 		}
-		RecalculatePolyobjectSegAngles(interp->polyobj.polyobj);
 		interp->polyobj.oldcx = interp->polyobj.bakcx;
 		interp->polyobj.oldcy = interp->polyobj.bakcy;
 		interp->polyobj.oldangle = interp->polyobj.bakangle;
 		interp->polyobj.bakcx = interp->polyobj.polyobj->centerPt.x;
 		interp->polyobj.bakcy = interp->polyobj.polyobj->centerPt.y;
 		interp->polyobj.bakangle = interp->polyobj.polyobj->angle;
+		if (interp->polyobj.oldcx != interp->polyobj.bakcx
+			|| interp->polyobj.oldcy != interp->polyobj.bakcy
+			|| interp->polyobj.oldangle != interp->polyobj.bakangle)
+			interp->changed = true;
+		// The seg angles were last calculated from these same vertices if it didn't move
+		if (interp->changed)
+			RecalculatePolyobjectSegAngles(interp->polyobj.polyobj);
 		break;
 	case LVLINTERP_DynSlope:
 		FV3_Copy(&interp->dynslope.oldo, &interp->dynslope.bako);
@@ -561,6 +584,9 @@ static void UpdateLevelInterpolatorState(levelinterpolator_t *interp)
 		FV3_Copy(&interp->dynslope.bako, &interp->dynslope.slope->o);
 		FV2_Copy(&interp->dynslope.bakd, &interp->dynslope.slope->d);
 		interp->dynslope.bakzdelta = interp->dynslope.slope->zdelta;
+		interp->changed = (memcmp(&interp->dynslope.oldo, &interp->dynslope.bako, sizeof(vector3_t))
+			|| memcmp(&interp->dynslope.oldd, &interp->dynslope.bakd, sizeof(vector2_t))
+			|| interp->dynslope.oldzdelta != interp->dynslope.bakzdelta);
 		break;
 	}
 }
@@ -602,6 +628,10 @@ void R_ApplyLevelInterpolators(fixed_t frac)
 	{
 		levelinterpolator_t *interp = levelinterpolators[i];
 
+		// Nothing to interpolate if it didn't move this tic, the game state already matches
+		if (!interp->changed)
+			continue;
+
 		switch (interp->type)
 		{
 		case LVLINTERP_SectorPlane:
@@ -660,6 +690,10 @@ void R_RestoreLevelInterpolators(void)
 	{
 		levelinterpolator_t *interp = levelinterpolators[i];
 
+		// Nothing to restore if it didn't move this tic, the game state already matches
+		if (!interp->changed)
+			continue;
+
 		switch (interp->type)
 		{
 		case LVLINTERP_SectorPlane:
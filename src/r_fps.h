@@ -86,6 +86,7 @@ typedef enum {
 typedef struct levelinterpolator_s {
 	levelinterpolator_type_e type;
 	thinker_t *thinker;
+	boolean changed; // Old and new states differ, so it needs to be applied and restored every frame
 	union {
 		struct {
 			sector_t *sector;
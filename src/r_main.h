@@ -109,6 +109,9 @@ extern ps_metric_t ps_numsprites;
 extern ps_metric_t ps_numdrawnodes;
 extern ps_metric_t ps_numpolyobjects;
 
+extern ps_metric_t ps_numtranslationhits;
+extern ps_metric_t ps_numtranslationmisses;
+
 //
 // REFRESH - the actual rendering functions.
 //
@@ -363,7 +363,7 @@ void *Picture_PatchConvert(
 	out->topoffset = intopoffset;
 
 	size_t max_pixels = out->width * out->height;
-	unsigned num_posts = 0;
+	unsigned num_posts = 0, max_posts = 0;
 
 	out->columns = Z_Calloc(sizeof(column_t) * out->width, PU_PATCH_DATA, NULL);
 	out->pixels = Z_Calloc(max_pixels * (outbpp / 8), PU_PATCH_DATA, NULL);
@@ -410,7 +410,12 @@ void *Picture_PatchConvert(
 			{
 				num_posts++;
 
-				out->posts = Z_Realloc(out->posts, sizeof(post_t) * num_posts, PU_PATCH_DATA, NULL);
+				// Grow the posts geometrically, rather than one at a time
+				if (num_posts > max_posts)
+				{
+					max_posts = max(max_posts * 2, 16);
+					out->posts = Z_Realloc(out->posts, sizeof(post_t) * max_posts, PU_PATCH_DATA, NULL);
+				}
 				post = &out->posts[num_posts - 1];
 				post->topdelta = (size_t)y;
 				post->length = 0;
@@ -431,6 +436,9 @@ void *Picture_PatchConvert(
 		}
 	}
 
+	if (num_posts && num_posts != max_posts)
+		out->posts = Z_Realloc(out->posts, sizeof(post_t) * num_posts, PU_PATCH_DATA, NULL);
+
 	UINT8 *old_pixels = out->pixels;
 	size_t total_pixels = imgptr - out->pixels;
 	if (total_pixels != max_pixels)
@@ -910,6 +918,85 @@ boolean Picture_IsLumpPNG(const UINT8 *d, size_t s)
 }
 
 #ifndef NO_PNG_LUMPS
+/** Reads the dimensions and grAb offsets of a PNG by walking its chunks,
+  * without decoding anything. Only the start of the file is needed,
+  * up to the first IDAT chunk.
+  *
+  * \param png The start of the PNG image.
+  * \param size How much of the image is in the buffer.
+  * \param width A pointer to the picture's width.
+  * \param height A pointer to the picture's height.
+  * \param topoffset A pointer to the picture's vertical offset.
+  * \param leftoffset A pointer to the picture's horizontal offset.
+  * \return 1 if everything was found, 0 if more of the file is needed,
+  *         or -1 if the image can't be read this way.
+  */
+INT32 Picture_PNGHeaderDimensions(const UINT8 *png, size_t size, INT32 *width, INT32 *height, INT16 *topoffset, INT16 *leftoffset)
+{
+	size_t pos = PNG_HEADER_SIZE;
+	boolean gotheader = false;
+	INT32 w = 0, h = 0, left = 0, top = 0;
+	boolean gotoffsets = false;
+
+#define PNGLONG(p) (INT32)(((UINT32)(p)[0] << 24) | ((UINT32)(p)[1] << 16) | ((UINT32)(p)[2] << 8) | (UINT32)(p)[3])
+	for (;;)
+	{
+		UINT32 length;
+		const UINT8 *type;
+
+		if (pos + 8 > size)
+			return 0;
+
+		length = (UINT32)PNGLONG(&png[pos]);
+		type = &png[pos + 4];
+
+		if (!gotheader)
+		{
+			// IHDR must come first
+			if (memcmp(type, "IHDR", 4) || length < 8)
+				return -1;
+			if (pos + 16 > size)
+				return 0;
+
+			w = PNGLONG(&png[pos + 8]);
+			h = PNGLONG(&png[pos + 12]);
+			gotheader = true;
+
+			// Leave images libpng would refuse to it
+			if (w <= 0 || h <= 0 || w > 2048 || h > 2048)
+				return -1;
+		}
+		else if (!memcmp(type, "grAb", 4) && length >= 8)
+		{
+			if (pos + 16 > size)
+				return 0;
+
+			left = PNGLONG(&png[pos + 8]);
+			top = PNGLONG(&png[pos + 12]);
+			gotoffsets = true;
+		}
+		else if (!memcmp(type, "IDAT", 4) || !memcmp(type, "IEND", 4))
+			break;
+
+		// Length, type, data and CRC
+		if (length > size)
+			return 0;
+		pos += 12 + length;
+	}
+#undef PNGLONG
+
+	*width = w;
+	*height = h;
+	if (gotoffsets)
+	{
+		if (leftoffset)
+			*leftoffset = (INT16)left;
+		if (topoffset)
+			*topoffset = (INT16)top;
+	}
+	return 1;
+}
+
 #ifdef HAVE_PNG
 
 /*#if PNG_LIBPNG_VER_DLLNUM < 14
@@ -111,6 +111,7 @@ typedef struct
 boolean Picture_IsLumpPNG(const UINT8 *d, size_t s);
 
 #ifndef NO_PNG_LUMPS
+INT32 Picture_PNGHeaderDimensions(const UINT8 *png, size_t size, INT32 *width, INT32 *height, INT16 *topoffset, INT16 *leftoffset);
 void *Picture_PNGConvert(
 	const UINT8 *png, pictureformat_t outformat,
 	INT32 *w, INT32 *h,
@@ -817,19 +817,11 @@ Rloadflats (INT32 i, INT32 w)
 
 		if (Picture_IsLumpPNG(header, lumplength))
 		{
-			INT32 texw, texh;
-			UINT8 *flatlump = W_CacheLumpNumPwad(wadnum, lumpnum, PU_CACHE);
-			if (Picture_PNGDimensions((UINT8 *)flatlump, &texw, &texh, NULL, NULL, lumplength))
-			{
-				width = (INT16)texw;
-				height = (INT16)texh;
-			}
-			else
+			if (!W_ReadPatchHeaderPwad(wadnum, lumpnum, &width, &height, NULL, NULL))
 			{
 				width = 1;
 				height = 1;
 			}
-			Z_Free(flatlump);
 		}
 #endif
 
@@ -73,6 +73,9 @@ consvar_t stereoreverse = CVAR_INIT ("stereoreverse", "Off", CV_SAVE, CV_OnOff,
 // if true, all sounds are loaded at game startup
 static consvar_t precachesound = CVAR_INIT ("precachesound", "Off", CV_SAVE, CV_OnOff, NULL);
 
+// if true, decoded sounds are kept on disk for the next time
+consvar_t cv_sfxcache = CVAR_INIT ("sfxcache", "On", CV_SAVE, CV_OnOff, NULL);
+
 // actual general (maximum) sound & music volume, saved into the config
 consvar_t cv_soundvolume = CVAR_INIT ("soundvolume", "16", CV_SAVE, soundvolume_cons_t, NULL);
 consvar_t cv_digmusicvolume = CVAR_INIT ("digmusicvolume", "16", CV_SAVE, soundvolume_cons_t, NULL);
@@ -186,6 +189,35 @@ void S_ResetCaptions(void)
 //
 static void S_StopChannel(INT32 cnum);
 
+//
+// S_SetChannelParams
+//
+// Records the parameters a channel's sound was started with.
+//
+static void S_SetChannelParams(INT32 cnum, INT32 volume, INT32 sep, INT32 pitch)
+{
+	channels[cnum].lastvolume = volume;
+	channels[cnum].lastsep = sep;
+	channels[cnum].lastpitch = pitch;
+}
+
+//
+// S_UpdateChannelParams
+//
+// Only passes changed parameters on to the sound interface,
+// which may have to lock the mixer for every call.
+//
+static void S_UpdateChannelParams(INT32 cnum, INT32 volume, INT32 sep, INT32 pitch)
+{
+	channel_t *c = &channels[cnum];
+
+	if (volume == c->lastvolume && sep == c->lastsep && pitch == c->lastpitch)
+		return;
+
+	S_SetChannelParams(cnum, volume, sep, pitch);
+	I_UpdateSoundParams(c->handle, volume, sep, pitch);
+}
+
 //
 // S_getChannel
 //
@@ -236,21 +268,31 @@ static INT32 S_getChannel(const void *origin, sfxinfo_t *sfxinfo)
 	// None available
 	if (cnum == numofchannels)
 	{
-		// Look for lower priority
+		// Look for the lowest priority, and the quietest among those
+		INT32 victim = -1;
+
 		for (cnum = 0; cnum < numofchannels; cnum++)
-			if (channels[cnum].sfxinfo->priority <= sfxinfo->priority)
-				break;
+		{
+			const sfxinfo_t *other = channels[cnum].sfxinfo;
 
-		if (cnum == numofchannels)
+			if (other->priority > sfxinfo->priority)
+				continue;
+
+			if (victim == -1 || other->priority < channels[victim].sfxinfo->priority
+				|| (other->priority == channels[victim].sfxinfo->priority
+				&& channels[cnum].lastvolume < channels[victim].lastvolume))
+				victim = cnum;
+		}
+
+		if (victim == -1)
 		{
 			// No lower priority. Sorry, Charlie.
 			return -1;
 		}
-		else
-		{
-			// Otherwise, kick out lower priority.
-			S_StopChannel(cnum);
-		}
+
+		// Otherwise, kick out lower priority.
+		cnum = victim;
+		S_StopChannel(cnum);
 	}
 
 	c = &channels[cnum];
@@ -272,6 +314,7 @@ void S_RegisterSoundStuff(void)
 
 	CV_RegisterVar(&stereoreverse);
 	CV_RegisterVar(&precachesound);
+	CV_RegisterVar(&cv_sfxcache);
 
 	CV_RegisterVar(&surround);
 	CV_RegisterVar(&cv_samplerate);
@@ -668,6 +711,7 @@ void S_StartSoundAtVolume(const void *origin_p, sfxenum_t sfx_id, INT32 volume)
 		// Assigns the handle to one of the channels in the
 		// mix/output buffer.
 		channels[cnum].handle = I_StartSound(sfx_id, volume, sep, pitch, priority, cnum);
+		S_SetChannelParams(cnum, volume, sep, pitch);
 	}
 
 dontplay:
@@ -722,6 +766,7 @@ dontplay:
 	// mix/output buffer.
 	channels[cnum].volume = initial_volume;
 	channels[cnum].handle = I_StartSound(sfx_id, volume, sep, pitch, priority, cnum);
+	S_SetChannelParams(cnum, volume, sep, pitch);
 }
 
 void S_StartSound(const void *origin, sfxenum_t sfx_id)
@@ -964,7 +1009,7 @@ void S_UpdateSounds(void)
 						}
 
 						if (audible)
-							I_UpdateSoundParams(c->handle, volume, sep, pitch);
+							S_UpdateChannelParams(cnum, volume, sep, pitch);
 						else
 							S_StopChannel(cnum);
 					}
@@ -975,7 +1020,7 @@ void S_UpdateSounds(void)
 							c->sfxinfo);
 
 						if (audible)
-							I_UpdateSoundParams(c->handle, volume, sep, pitch);
+							S_UpdateChannelParams(cnum, volume, sep, pitch);
 						else
 							S_StopChannel(cnum);
 					}
@@ -1021,12 +1066,18 @@ void S_UpdateClosedCaptions(void)
 
 void S_SetSfxVolume(INT32 volume)
 {
+	INT32 i;
+
 	if (volume < 0 || volume > 31)
 		CONS_Alert(CONS_WARNING, "sfxvolume should be between 0-31\n");
 
 	CV_SetValue(&cv_soundvolume, volume&0x1F);
 	actualsfxvolume = cv_soundvolume.value; // check for change of var
 
+	// Playing sounds need their volume applied again
+	for (i = 0; i < numofchannels; i++)
+		channels[i].lastvolume = -1;
+
 #ifdef HW3SOUND
 	hws_mode == HWS_DEFAULT_MODE ? I_SetSfxVolume(volume&0x1F) : HW3S_SetSfxVolume(volume&0x1F);
 #else
@@ -1352,6 +1403,69 @@ void S_InitSfxChannels(INT32 sfxVolume)
 	}
 }
 
+static void S_PrecacheSound(sfxenum_t sfx_id)
+{
+	sfxinfo_t *sfx;
+
+	if (sfx_id <= sfx_None || sfx_id >= NUMSFX)
+		return;
+
+	sfx = &S_sfx[sfx_id];
+
+	if (sfx->name && !sfx->data)
+		sfx->data = I_GetSfx(sfx);
+}
+
+//
+// S_PrecacheLevelSounds
+//
+// Decodes the sounds of every mobj type in the level, and the skin
+// sounds of any mobj with a skin, so that they don't have to be
+// decoded mid-game the first time they are played.
+//
+void S_PrecacheLevelSounds(void)
+{
+	boolean *typepresent;
+	thinker_t *th;
+	size_t i, j;
+
+	if (dedicated || sound_disabled)
+		return;
+
+	typepresent = calloc(NUMMOBJTYPES, sizeof (*typepresent));
+	if (typepresent == NULL) I_Error("%s: Out of memory looking up mobj types", "S_PrecacheLevelSounds");
+
+	for (th = thlist[THINK_MOBJ].next; th != &thlist[THINK_MOBJ]; th = th->next)
+	{
+		const mobj_t *mo = (mobj_t *)th;
+
+		if (th->function.acp1 == (actionf_p1)P_RemoveThinkerDelayed)
+			continue;
+
+		typepresent[mo->type] = true;
+
+		if (mo->skin)
+		{
+			for (j = 0; j < NUMSKINSOUNDS; j++)
+				S_PrecacheSound(((skin_t *)mo->skin)->soundsid[j]);
+		}
+	}
+
+	for (i = 0; i < NUMMOBJTYPES; i++)
+	{
+		if (!typepresent[i])
+			continue;
+
+		S_PrecacheSound(mobjinfo[i].seesound);
+		S_PrecacheSound(mobjinfo[i].attacksound);
+		S_PrecacheSound(mobjinfo[i].painsound);
+		S_PrecacheSound(mobjinfo[i].deathsound);
+		S_PrecacheSound(mobjinfo[i].activesound);
+	}
+
+	free(typepresent);
+}
+
 /// ------------------------
 /// Music
 /// ------------------------
@@ -2692,7 +2806,7 @@ void MusicPref_OnChange(void)
 #ifdef HAVE_OPENMPT
 void ModFilter_OnChange(void)
 {
-	if (openmpt_mhandle)
-		openmpt_module_set_render_param(openmpt_mhandle, OPENMPT_MODULE_RENDER_INTERPOLATIONFILTER_LENGTH, cv_modfilter.value);
+	// The stream thread may be rendering the module right now
+	I_SetModFilter(cv_modfilter.value);
 }
 #endif
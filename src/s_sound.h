@@ -31,6 +31,7 @@ extern openmpt_module *openmpt_mhandle;
 extern consvar_t stereoreverse;
 extern consvar_t cv_soundvolume, cv_closedcaptioning, cv_digmusicvolume, cv_midimusicvolume;
 extern consvar_t cv_numChannels;
+extern consvar_t cv_sfxcache;
 
 extern consvar_t cv_resetmusic;
 extern consvar_t cv_resetmusicbyheader;
@@ -93,6 +94,9 @@ typedef struct
 	// handle of the sound being played
 	INT32 handle;
 
+	// parameters last passed to the sound interface, -1 to force an update
+	INT32 lastvolume, lastsep, lastpitch;
+
 } channel_t;
 
 typedef struct {
@@ -119,6 +123,9 @@ void S_RegisterSoundStuff(void);
 //
 void S_InitSfxChannels(INT32 sfxVolume);
 
+// Decodes the sounds the level's mobjs can make, after it was loaded
+void S_PrecacheLevelSounds(void);
+
 //
 // Per level startup code.
 // Kills playing sounds at start of level, determines music if any, changes music.
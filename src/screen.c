@@ -164,8 +164,8 @@ void SCR_SetMode(void)
 	// Lactozilla: Renderer switching
 	if (setrenderneeded)
 	{
-		// stop recording movies (APNG only)
-		if (setrenderneeded && (moviemode == MM_APNG))
+		// stop recording movies (APNG and Y4M only)
+		if (setrenderneeded && (moviemode == MM_APNG || moviemode == MM_Y4M))
 			M_StopMovie();
 
 		// VID_SetMode will call VID_CheckRenderer itself,
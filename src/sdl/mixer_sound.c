@@ -40,6 +40,10 @@
 #include "../w_wad.h"
 #include "../z_zone.h"
 #include "../byteptr.h"
+#include "../d_main.h" // srb2home
+#include "../i_system.h" // I_mkdir
+#include "../m_misc.h" // FIL_ReadFile
+#include "../md5.h"
 
 #ifdef _MSC_VER
 #pragma warning(disable : 4214 4244)
@@ -115,12 +119,14 @@ static boolean fading_nocleanup;
 #ifdef HAVE_GME
 static Music_Emu *gme;
 static UINT16 current_track;
+static INT32 track_length, track_intro_length, track_loop_length; // of current_track
 #endif
 
 #ifdef HAVE_OPENMPT
 static int mod_err = OPENMPT_ERROR_OK;
 static const char *mod_err_str;
 static UINT16 current_subsong;
+static UINT32 subsong_duration; // in ms, of current_subsong
 static size_t probesize;
 static int result;
 #endif
@@ -318,6 +324,248 @@ static const char* get_zlib_error(int zErr)
 }
 #endif
 
+#if defined (HAVE_GME) || defined (HAVE_OPENMPT)
+/// ------------------------
+/// Music Stream
+/// ------------------------
+
+// GME and libopenmpt music is rendered ahead of time by a thread of its
+// own, into a ring buffer that the music callback only copies from.
+// Neither rendering nor seeking, which GME does by emulating up to the
+// new position, can stall the audio callback that way.
+//
+// The emulator may only be touched while holding stream_mutex. The
+// stream thread is the only one to move stream_write, and the callback
+// the only one to move stream_read, except for flushes, which hold both
+// stream_mutex and the audio lock.
+
+#define STREAM_FRAMES 16384 // power of two, about 370 ms at 44.1 kHz
+#define STREAM_CHUNK 1024 // frames rendered at a time
+
+static Sint16 stream_buffer[STREAM_FRAMES*2];
+static SDL_atomic_t stream_read, stream_write; // frame counters, wrap around
+static SDL_atomic_t stream_seek; // pending seek in ms, or -1
+static SDL_atomic_t stream_position; // position in ms at stream_write
+static SDL_atomic_t stream_quit;
+static boolean stream_ended; // protected by stream_mutex
+static SDL_mutex *stream_mutex;
+static SDL_sem *stream_wake;
+static SDL_Thread *stream_thread;
+
+static void LockStream(void)
+{
+	if (stream_mutex)
+		SDL_LockMutex(stream_mutex);
+}
+
+static void UnlockStream(void)
+{
+	if (stream_mutex)
+		SDL_UnlockMutex(stream_mutex);
+}
+
+// Renders up to frames frames of the song, returns how many were rendered
+static int RenderStream(Sint16 *out, int frames)
+{
+#ifdef HAVE_GME
+	if (gme)
+	{
+		if (gme_track_ended(gme))
+			return 0;
+
+		gme_play(gme, frames*2, out);
+		SDL_AtomicSet(&stream_position, gme_tell(gme));
+		return frames;
+	}
+#endif
+#ifdef HAVE_OPENMPT
+	if (openmpt_mhandle)
+	{
+		frames = (int)openmpt_module_read_interleaved_stereo(openmpt_mhandle, SAMPLERATE, frames, out);
+		SDL_AtomicSet(&stream_position, (int)(openmpt_module_get_position_seconds(openmpt_mhandle)*1000.));
+		return frames;
+	}
+#endif
+	(void)out;
+	(void)frames;
+	return 0;
+}
+
+static void SeekStream(UINT32 position)
+{
+#ifdef HAVE_GME
+	if (gme)
+		gme_seek(gme, position); // this isn't required to succeed
+#endif
+#ifdef HAVE_OPENMPT
+	if (openmpt_mhandle)
+		openmpt_module_set_position_seconds(openmpt_mhandle, (double)(position/1000.0L));
+#endif
+	SDL_AtomicSet(&stream_position, position);
+	stream_ended = false;
+}
+
+// Throws away the prebuffered audio, after the emulator jumped elsewhere.
+// Must be called with stream_mutex held.
+static void FlushStream(void)
+{
+	SDL_LockAudio();
+	SDL_AtomicSet(&stream_read, SDL_AtomicGet(&stream_write));
+	SDL_UnlockAudio();
+	stream_ended = false;
+}
+
+static int StreamThread(void *userdata)
+{
+	(void)userdata;
+
+	while (!SDL_AtomicGet(&stream_quit))
+	{
+		const int seek = SDL_AtomicSet(&stream_seek, -1);
+		Uint32 r, w, offset, frames;
+		boolean idle;
+
+		SDL_LockMutex(stream_mutex);
+
+		if (seek >= 0)
+		{
+			FlushStream();
+			SeekStream((UINT32)seek);
+		}
+
+		r = (Uint32)SDL_AtomicGet(&stream_read);
+		w = (Uint32)SDL_AtomicGet(&stream_write);
+		offset = w & (STREAM_FRAMES-1);
+
+		frames = STREAM_FRAMES - (w - r);
+		frames = min(frames, STREAM_CHUNK);
+		frames = min(frames, STREAM_FRAMES - offset);
+
+		idle = (frames == 0 || stream_ended);
+
+		if (!idle)
+		{
+			const int rendered = RenderStream(&stream_buffer[offset*2], (int)frames);
+
+			if (rendered > 0)
+				SDL_AtomicSet(&stream_write, (int)(w + (Uint32)rendered));
+			else
+				stream_ended = true;
+		}
+
+		SDL_UnlockMutex(stream_mutex);
+
+		// Wait for the callback to make room, or for a seek
+		if (idle)
+			SDL_SemWaitTimeout(stream_wake, 100);
+	}
+
+	return 0;
+}
+
+static void StartStream(void)
+{
+	if (stream_thread || !stream_mutex)
+		return;
+
+	SDL_AtomicSet(&stream_read, 0);
+	SDL_AtomicSet(&stream_write, 0);
+	SDL_AtomicSet(&stream_seek, -1);
+	SDL_AtomicSet(&stream_position, 0);
+	SDL_AtomicSet(&stream_quit, 0);
+	stream_ended = false;
+
+	stream_thread = SDL_CreateThread(StreamThread, "SRB2 music", NULL);
+	if (!stream_thread)
+		CONS_Alert(CONS_WARNING, "Couldn't start the music thread, rendering music in the audio callback: %s\n", SDL_GetError());
+}
+
+static void StopStream(void)
+{
+	if (!stream_thread)
+		return;
+
+	SDL_AtomicSet(&stream_quit, 1);
+	SDL_SemPost(stream_wake);
+	SDL_WaitThread(stream_thread, NULL);
+	stream_thread = NULL;
+}
+
+// Seeks on the stream thread, so the caller doesn't wait for it
+static void RequestStreamSeek(UINT32 position)
+{
+	if (stream_thread)
+	{
+		SDL_AtomicSet(&stream_seek, (int)position);
+		SDL_SemPost(stream_wake);
+	}
+	else
+	{
+		LockStream();
+		SeekStream(position);
+		UnlockStream();
+	}
+}
+
+// Position of what the callback currently plays, in ms
+static UINT32 StreamPosition(void)
+{
+	const int seek = SDL_AtomicGet(&stream_seek);
+	Uint32 buffered;
+	INT32 position;
+
+	if (seek >= 0)
+		return (UINT32)seek;
+
+	buffered = (Uint32)SDL_AtomicGet(&stream_write) - (Uint32)SDL_AtomicGet(&stream_read);
+	position = SDL_AtomicGet(&stream_position) - (INT32)((UINT64)buffered * 1000 / SAMPLERATE);
+
+	return (UINT32)max(position, 0);
+}
+
+// Fills the music callback's stream, which the mixer has already cleared
+static void mix_stream(Uint8 *stream, int len)
+{
+	Sint16 *out = (Sint16 *)stream;
+	Uint32 frames = (Uint32)len / 4;
+	Uint32 r, avail, offset, first, i;
+	short *p;
+
+	if (!stream_thread)
+	{
+		// Fall back to rendering here, unless the emulator is busy
+		if (SDL_TryLockMutex(stream_mutex) != 0)
+			return;
+		frames = (Uint32)max(RenderStream(out, (int)frames), 0);
+		SDL_UnlockMutex(stream_mutex);
+	}
+	else
+	{
+		r = (Uint32)SDL_AtomicGet(&stream_read);
+		avail = (Uint32)SDL_AtomicGet(&stream_write) - r;
+		frames = min(frames, avail);
+		offset = r & (STREAM_FRAMES-1);
+		first = min(frames, STREAM_FRAMES - offset);
+
+		// Whatever is missing on underrun stays silent
+		M_Memcpy(out, &stream_buffer[offset*2], first*4);
+		M_Memcpy(out + first*2, stream_buffer, (frames - first)*4);
+
+		SDL_AtomicSet(&stream_read, (int)(r + frames));
+		if (SDL_SemValue(stream_wake) == 0)
+			SDL_SemPost(stream_wake);
+	}
+
+	// Limiter to prevent music from being disorted with some formats
+	if (music_volume >= 18)
+		music_volume = 18;
+
+	// apply volume to stream
+	for (i = 0, p = out; i < frames*2; i++, p++)
+		*p = ((INT32)*p) * music_volume * internal_volume / 100 / 20;
+}
+#endif
+
 /// ------------------------
 /// Audio System
 /// ------------------------
@@ -375,6 +623,11 @@ void I_StartupSound(void)
 	CONS_Printf("libopenmpt build date: %s\n", openmpt_get_string("build"));
 #endif
 
+#if defined (HAVE_GME) || defined (HAVE_OPENMPT)
+	stream_mutex = SDL_CreateMutex();
+	stream_wake = SDL_CreateSemaphore(0);
+#endif
+
 	sound_started = true;
 	songpaused = false;
 	Mix_AllocateChannels(256);
@@ -386,6 +639,10 @@ void I_ShutdownSound(void)
 		return; // not an error condition
 	sound_started = false;
 
+#if defined (HAVE_GME) || defined (HAVE_OPENMPT)
+	StopStream();
+#endif
+
 	Mix_CloseAudio();
 #if SDL_MIXER_VERSION_ATLEAST(1,2,11)
 	Mix_Quit();
@@ -401,6 +658,13 @@ void I_ShutdownSound(void)
 	if (openmpt_mhandle)
 		openmpt_module_destroy(openmpt_mhandle);
 #endif
+
+#if defined (HAVE_GME) || defined (HAVE_OPENMPT)
+	SDL_DestroySemaphore(stream_wake);
+	SDL_DestroyMutex(stream_mutex);
+	stream_wake = NULL;
+	stream_mutex = NULL;
+#endif
 }
 
 void I_UpdateSound(void)
@@ -530,11 +794,135 @@ static Mix_Chunk *ds2chunk(void *stream)
 	return Mix_QuickLoad_RAW(sound, (Uint32)((UINT8*)d-sound));
 }
 
+#ifndef NOMD5
+// Sounds that need real decoding (OGG, WAVE, GME) are kept in
+// srb2home/sfxcache as PCM in the mixer's output format, named after
+// the MD5 of their lump. The header records that format, so changing
+// the sample rate or channel layout just misses the cache.
+#define SFXCACHE_MAGIC "SRB2PCM1"
+#define SFXCACHE_MAGICLEN 8
+#define SFXCACHE_HEADERSIZE (SFXCACHE_MAGICLEN + 4 + 2 + 2 + 4)
+
+static const char *SfxCachePath(const UINT8 *key)
+{
+	return va("%s" PATHSEP "sfxcache" PATHSEP
+		"%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x.pcm", srb2home,
+		key[0], key[1], key[2], key[3], key[4], key[5], key[6], key[7],
+		key[8], key[9], key[10], key[11], key[12], key[13], key[14], key[15]);
+}
+
+static Mix_Chunk *SfxCacheLoad(const UINT8 *key)
+{
+	UINT8 *file = NULL;
+	size_t length = FIL_ReadFile(SfxCachePath(key), &file);
+	UINT8 *p = file;
+	UINT8 *pcm;
+	UINT32 pcmlen;
+	int freq, channels;
+	Uint16 format;
+
+	if (length < SFXCACHE_HEADERSIZE || !Mix_QuerySpec(&freq, &format, &channels))
+	{
+		if (file)
+			Z_Free(file);
+		return NULL;
+	}
+
+	if (memcmp(p, SFXCACHE_MAGIC, SFXCACHE_MAGICLEN) != 0)
+	{
+		Z_Free(file);
+		return NULL;
+	}
+	p += SFXCACHE_MAGICLEN;
+
+	if (READUINT32(p) != (UINT32)freq || READUINT16(p) != format || READUINT16(p) != (UINT16)channels)
+	{
+		Z_Free(file);
+		return NULL;
+	}
+
+	pcmlen = READUINT32(p);
+	if (pcmlen == 0 || pcmlen != length - SFXCACHE_HEADERSIZE)
+	{
+		Z_Free(file);
+		return NULL;
+	}
+
+	// I_FreeSfx frees the buffer of chunks it didn't get from the
+	// mixer, so it has to be a block of its own
+	pcm = Z_Malloc(pcmlen, PU_SOUND, NULL);
+	M_Memcpy(pcm, p, pcmlen);
+	Z_Free(file);
+
+	return Mix_QuickLoad_RAW(pcm, pcmlen);
+}
+
+static void SfxCacheStore(const UINT8 *key, const Mix_Chunk *chunk)
+{
+	UINT8 header[SFXCACHE_HEADERSIZE];
+	UINT8 *p = header;
+	const char *path;
+	char tmppath[MAX_WADPATH];
+	int freq, channels;
+	Uint16 format;
+	FILE *f;
+	boolean written;
+
+	if (!chunk->alen || !Mix_QuerySpec(&freq, &format, &channels))
+		return;
+
+	M_Memcpy(p, SFXCACHE_MAGIC, SFXCACHE_MAGICLEN);
+	p += SFXCACHE_MAGICLEN;
+	WRITEUINT32(p, (UINT32)freq);
+	WRITEUINT16(p, format);
+	WRITEUINT16(p, (UINT16)channels);
+	WRITEUINT32(p, chunk->alen);
+
+	I_mkdir(va("%s" PATHSEP "sfxcache", srb2home), 0755);
+
+	// write under a temporary name, so a crash can't leave half an entry
+	path = SfxCachePath(key);
+	snprintf(tmppath, sizeof tmppath, "%s.tmp", path);
+
+	f = fopen(tmppath, "wb");
+	if (!f)
+		return;
+
+	written = fwrite(header, 1, sizeof header, f) == sizeof header
+		&& fwrite(chunk->abuf, 1, chunk->alen, f) == chunk->alen;
+
+	if (fclose(f) == 0 && written)
+	{
+		remove(path);
+		if (rename(tmppath, path) != 0)
+			remove(tmppath);
+	}
+	else
+		remove(tmppath);
+}
+#endif
+
+// Stores a chunk that had to be decoded, then returns it
+static Mix_Chunk *CacheDecoded(const UINT8 *key, Mix_Chunk *chunk)
+{
+#ifndef NOMD5
+	if (chunk && key)
+		SfxCacheStore(key, chunk);
+#else
+	(void)key;
+#endif
+	return chunk;
+}
+
 void *I_GetSfx(sfxinfo_t *sfx)
 {
 	void *lump;
 	Mix_Chunk *chunk;
 	SDL_RWops *rw;
+	const UINT8 *key = NULL;
+#ifndef NOMD5
+	UINT8 keybuf[16];
+#endif
 #ifdef HAVE_GME
 	Music_Emu *emu;
 	gme_info_t *info;
@@ -554,6 +942,22 @@ void *I_GetSfx(sfxinfo_t *sfx)
 		return chunk;
 	}
 
+	// Anything else is expensive to decode, so check the cache first.
+#ifndef NOMD5
+	if (cv_sfxcache.value)
+	{
+		md5_buffer(lump, sfx->length, keybuf);
+		key = keybuf;
+
+		chunk = SfxCacheLoad(key);
+		if (chunk)
+		{
+			Z_Free(lump);
+			return chunk;
+		}
+	}
+#endif
+
 	// Not a doom sound? Try something else.
 #ifdef HAVE_GME
 	// VGZ format
@@ -600,7 +1004,7 @@ void *I_GetSfx(sfxinfo_t *sfx)
 					gme_free_info(info);
 					gme_delete(emu);
 
-					return Mix_QuickLoad_RAW((Uint8 *)mem, len);
+					return CacheDecoded(key, Mix_QuickLoad_RAW((Uint8 *)mem, len));
 				}
 			}
 			else
@@ -633,7 +1037,7 @@ void *I_GetSfx(sfxinfo_t *sfx)
 		gme_free_info(info);
 		gme_delete(emu);
 
-		return Mix_QuickLoad_RAW((Uint8 *)mem, len);
+		return CacheDecoded(key, Mix_QuickLoad_RAW((Uint8 *)mem, len));
 	}
 #endif
 
@@ -642,7 +1046,7 @@ void *I_GetSfx(sfxinfo_t *sfx)
 	if (rw != NULL)
 	{
 		chunk = Mix_LoadWAV_RW(rw, 1);
-		return chunk;
+		return CacheDecoded(key, chunk);
 	}
 
 	return NULL; // haven't been able to get anything
@@ -815,49 +1219,45 @@ static UINT32 music_fade(UINT32 interval, void *param)
 #ifdef HAVE_GME
 static void mix_gme(void *udata, Uint8 *stream, int len)
 {
-	int i;
-	short *p;
-
 	(void)udata;
 
 	// no gme? no music.
-	if (!gme || gme_track_ended(gme) || songpaused)
+	if (!gme || songpaused)
 		return;
 
-	// play gme into stream
-	gme_play(gme, len/2, (short *)stream);
+	mix_stream(stream, len);
+}
 
-	// Limiter to prevent music from being disorted with some formats
-	if (music_volume >= 18)
-		music_volume = 18;
+// Keeps the lengths of the current track, so the game thread doesn't
+// have to query the emulator while it is rendering
+static void CacheTrackInfo(void)
+{
+	gme_info_t *info;
+	gme_err_t gme_e = gme_track_info(gme, &info, current_track);
 
-	// apply volume to stream
-	for (i = 0, p = (short *)stream; i < len / 2; i++, p++)
-		*p = ((INT32)*p) * music_volume * internal_volume / 100 / 20;
+	if (gme_e != NULL)
+	{
+		CONS_Alert(CONS_ERROR, "GME error: %s\n", gme_e);
+		track_length = track_intro_length = track_loop_length = 0;
+		return;
+	}
+
+	track_length = info->length;
+	track_intro_length = info->intro_length;
+	track_loop_length = info->loop_length;
+	gme_free_info(info);
 }
 #endif
 
 #ifdef HAVE_OPENMPT
 static void mix_openmpt(void *udata, Uint8 *stream, int len)
 {
-	int i;
-	short *p;
-
 	(void)udata;
 
 	if (!openmpt_mhandle || songpaused)
 		return;
 
-	// Play module into stream
-	openmpt_module_read_interleaved_stereo(openmpt_mhandle, SAMPLERATE, BUFFERSIZE, (short *)stream);
-
-	// Limiter to prevent music from being disorted with some formats
-	if (music_volume >= 18)
-		music_volume = 18;
-
-	// apply volume to stream
-	for (i = 0, p = (short *)stream; i < len / 2; i++, p++)
-		*p = ((INT32)*p) * music_volume * internal_volume / 100 / 20;
+	mix_stream(stream, len);
 }
 #endif
 
@@ -939,9 +1339,9 @@ void I_SetSongSpeed(float speed) // StarManiaKG: was originally boolean, no long
 #ifdef HAVE_GME
 	if (gme)
 	{
-		SDL_LockAudio();
+		LockStream();
 		gme_set_tempo(gme, speed);
-		SDL_UnlockAudio();
+		UnlockStream();
 		return;
 	}
 #endif
@@ -957,10 +1357,14 @@ void I_SetSongSpeed(float speed) // StarManiaKG: was originally boolean, no long
 			// deprecated in 0.5.0
 			char modspd[13];
 			sprintf(modspd, "%g", speed);
+			LockStream();
 			openmpt_module_ctl_set(openmpt_mhandle, "play.tempo_factor", modspd);
+			UnlockStream();
 		}
 #else
+		LockStream();
 		openmpt_module_ctl_set_floatingpoint(openmpt_mhandle, "play.tempo_factor", (double)speed);
+		UnlockStream();
 #endif
 
 		return;
@@ -1015,9 +1419,9 @@ void I_SetSongPitch(float pitch)
 #ifdef HAVE_GME
 	if (gme)
 	{
-		SDL_LockAudio();
+		LockStream();
 		gme_set_stereo_depth(gme, pitch);
-		SDL_UnlockAudio();
+		UnlockStream();
 		return;
 	}
 #endif
@@ -1032,9 +1436,13 @@ void I_SetSongPitch(float pitch)
 		// deprecated in 0.5.0
 		char modspd[13];
 		sprintf(modspd, "%g", pitch);
+		LockStream();
 		openmpt_module_ctl_set(openmpt_mhandle, "play.pitch_factor", modspd);
+		UnlockStream();
 #else
+		LockStream();
 		openmpt_module_ctl_set_floatingpoint(openmpt_mhandle, "play.pitch_factor", (double)pitch);
+		UnlockStream();
 #endif
 
 		return;
@@ -1070,6 +1478,20 @@ float I_GetSongPitch(void)
 	return music_pitch;
 }
 
+void I_SetModFilter(INT32 filter)
+{
+#ifdef HAVE_OPENMPT
+	if (openmpt_mhandle)
+	{
+		LockStream();
+		openmpt_module_set_render_param(openmpt_mhandle, OPENMPT_MODULE_RENDER_INTERPOLATIONFILTER_LENGTH, filter);
+		UnlockStream();
+	}
+#else
+	(void)filter;
+#endif
+}
+
 /// ------------------------
 ///  MUSIC SEEKING
 /// ------------------------
@@ -1081,35 +1503,23 @@ UINT32 I_GetSongLength(void)
 #ifdef HAVE_GME
 	if (gme)
 	{
-		gme_info_t *info;
-		gme_err_t gme_e = gme_track_info(gme, &info, current_track);
-
-		if (gme_e != NULL)
+		// reconstruct info->play_length, from GME source
+		// we only want intro + 1 loop, not 2
+		length = track_length;
+		if (length <= 0)
 		{
-			CONS_Alert(CONS_ERROR, "GME error: %s\n", gme_e);
-			length = 0;
-		}
-		else
-		{
-			// reconstruct info->play_length, from GME source
-			// we only want intro + 1 loop, not 2
-			length = info->length;
+			length = track_intro_length + track_loop_length; // intro + 1 loop
 			if (length <= 0)
-			{
-				length = info->intro_length + info->loop_length; // intro + 1 loop
-				if (length <= 0)
-					length = 150 * 1000; // 2.5 minutes
-			}
+				length = 150 * 1000; // 2.5 minutes
 		}
 
-		gme_free_info(info);
 		return max(length, 0);
 	}
 	else
 #endif
 #ifdef HAVE_OPENMPT
 	if (openmpt_mhandle)
-		return (UINT32)(openmpt_module_get_duration_seconds(openmpt_mhandle) * 1000.);
+		return subsong_duration;
 	else
 #endif
 	if (!music || I_SongType() == MU_MOD || I_SongType() == MU_MID)
@@ -1155,22 +1565,7 @@ UINT32 I_GetSongLoopPoint(void)
 {
 #ifdef HAVE_GME
 	if (gme)
-	{
-		INT32 looppoint;
-		gme_info_t *info;
-		gme_err_t gme_e = gme_track_info(gme, &info, current_track);
-
-		if (gme_e != NULL)
-		{
-			CONS_Alert(CONS_ERROR, "GME error: %s\n", gme_e);
-			looppoint = 0;
-		}
-		else
-			looppoint = info->intro_length > 0 ? info->intro_length : 0;
-
-		gme_free_info(info);
-		return max(looppoint, 0);
-	}
+		return (UINT32)max(track_intro_length, 0);
 	else
 #endif
 	if (!music || I_SongType() == MU_MOD || I_SongType() == MU_MID)
@@ -1185,25 +1580,15 @@ boolean I_SetSongPosition(UINT32 position)
 #ifdef HAVE_GME
 	if (gme)
 	{
-		// this is unstable, so fail silently
+		// GME seeks by emulating up to the position, which takes a while,
+		// so the stream thread does it. Seeking too far makes it take even
+		// longer, so clamp to the song's length first.
+		length = I_GetSongLength();
+		if (length)
+			position = get_adjusted_position(position);
+
+		RequestStreamSeek(position);
 		return true;
-		// this isn't required technically, but GME thread-locks for a second
-		// if you seek too high from the counter
-		// length = I_GetSongLength();
-		// if (length)
-		// 	position = get_adjusted_position(position);
-
-		// SDL_LockAudio();
-		// gme_err_t gme_e = gme_seek(gme, position);
-		// SDL_UnlockAudio();
-
-		// if (gme_e != NULL)
-		// {
-		// 	CONS_Alert(CONS_ERROR, "GME error: %s\n", gme_e);
-		// 	return false;
-		// }
-		// else
-		// 	return true;
 	}
 	else
 #endif
@@ -1212,7 +1597,7 @@ boolean I_SetSongPosition(UINT32 position)
 	{
 		// This isn't 100% correct because we don't account for loop points because we can't get them.
 		// But if you seek past end of song, OpenMPT seeks to 0. So adjust the position anyway.
-		openmpt_module_set_position_seconds(openmpt_mhandle, (double)(get_adjusted_position(position)/1000.0L)); // returns new position
+		RequestStreamSeek(get_adjusted_position(position));
 		return true;
 	}
 	else
@@ -1248,28 +1633,16 @@ UINT32 I_GetSongPosition(void)
 #ifdef HAVE_GME
 	if (gme)
 	{
-		INT32 position = gme_tell(gme);
-
-		gme_info_t *info;
-		gme_err_t gme_e = gme_track_info(gme, &info, current_track);
+		INT32 position = (INT32)StreamPosition();
 
-		if (gme_e != NULL)
-		{
-			CONS_Alert(CONS_ERROR, "GME error: %s\n", gme_e);
-			return position;
-		}
+		// adjust position, since GME's counter keeps going past loop
+		if (track_length > 0)
+			position %= track_length;
+		else if (track_intro_length + track_loop_length > 0)
+			position = position >= (track_intro_length + track_loop_length) ? (position % track_loop_length) : position;
 		else
-		{
-			// adjust position, since GME's counter keeps going past loop
-			if (info->length > 0)
-				position %= info->length;
-			else if (info->intro_length + info->loop_length > 0)
-				position = position >= (info->intro_length + info->loop_length) ? (position % info->loop_length) : position;
-			else
-				position %= 150 * 1000; // 2.5 minutes
-		}
+			position %= 150 * 1000; // 2.5 minutes
 
-		gme_free_info(info);
 		return max(position, 0);
 	}
 	else
@@ -1278,8 +1651,8 @@ UINT32 I_GetSongPosition(void)
 	if (openmpt_mhandle)
 		// This will be incorrect if we adjust for length because we can't get loop points.
 		// So return unadjusted. See note in SetMusicPosition: we adjust for that.
-		return (UINT32)(openmpt_module_get_position_seconds(openmpt_mhandle)*1000.);
-		//return get_adjusted_position((UINT32)(openmpt_module_get_position_seconds(openmpt_mhandle)*1000.));
+		return StreamPosition();
+		//return get_adjusted_position(StreamPosition());
 	else
 #endif
 	if (!music || I_SongType() == MU_MID)
@@ -1495,6 +1868,8 @@ boolean I_PlaySong(boolean looping)
 		gme_set_equalizer(gme, &eq);
 		gme_start_track(gme, 0);
 		current_track = 0;
+		CacheTrackInfo();
+		StartStream();
 		Mix_HookMusic(mix_gme, gme);
 		return true;
 	}
@@ -1508,6 +1883,8 @@ boolean I_PlaySong(boolean looping)
 		if (looping)
 			openmpt_module_set_repeat_count(openmpt_mhandle, -1); // Always repeat
 		current_subsong = 0;
+		subsong_duration = (UINT32)(openmpt_module_get_duration_seconds(openmpt_mhandle) * 1000.);
+		StartStream();
 		Mix_HookMusic(mix_openmpt, openmpt_mhandle);
 		return true;
 	}
@@ -1554,6 +1931,7 @@ void I_StopSong(void)
 	if (gme)
 	{
 		Mix_HookMusic(NULL, NULL);
+		StopStream();
 		current_track = -1;
 	}
 #endif
@@ -1561,6 +1939,7 @@ void I_StopSong(void)
 	if (openmpt_mhandle)
 	{
 		Mix_HookMusic(NULL, NULL);
+		StopStream();
 		current_subsong = -1;
 	}
 #endif
@@ -1631,20 +2010,23 @@ boolean I_SetSongTrack(INT32 track)
 	{
 		if (current_track == track)
 			return false;
-		SDL_LockAudio();
+		LockStream();
 		if (track >= 0 && track < gme_track_count(gme)-1)
 		{
 			gme_err_t gme_e = gme_start_track(gme, track);
 			if (gme_e != NULL)
 			{
+				UnlockStream();
 				CONS_Alert(CONS_ERROR, "GME error: %s\n", gme_e);
 				return false;
 			}
 			current_track = track;
-			SDL_UnlockAudio();
+			CacheTrackInfo();
+			FlushStream();
+			UnlockStream();
 			return true;
 		}
-		SDL_UnlockAudio();
+		UnlockStream();
 		return false;
 	}
 	else
@@ -1654,15 +2036,17 @@ boolean I_SetSongTrack(INT32 track)
 	{
 		if (current_subsong == track)
 			return false;
-		SDL_LockAudio();
+		LockStream();
 		if (track >= 0 && track < openmpt_module_get_num_subsongs(openmpt_mhandle))
 		{
 			openmpt_module_select_subsong(openmpt_mhandle, track);
 			current_subsong = track;
-			SDL_UnlockAudio();
+			subsong_duration = (UINT32)(openmpt_module_get_duration_seconds(openmpt_mhandle) * 1000.);
+			FlushStream();
+			UnlockStream();
 			return true;
 		}
-		SDL_UnlockAudio();
+		UnlockStream();
 
 		return false;
 	}
@@ -1392,6 +1392,11 @@ float I_GetSongPitch(void)
     return 0.0f;
 }
 
+void I_SetModFilter(INT32 filter)
+{
+    (void)filter;
+}
+
 /// ------------------------
 //  MUSIC SEEKING
 /// ------------------------
@@ -28,6 +28,19 @@ taggroup_t* tags_sectors[MAXTAGS + 1];
 taggroup_t* tags_lines[MAXTAGS + 1];
 taggroup_t* tags_mapthings[MAXTAGS + 1];
 
+// Lines sorted by special, then by id, so all lines with a given special
+// can be found with a binary search instead of scanning every line.
+// Built once the specials are final, see Taglist_InitLineSpecials.
+typedef struct
+{
+	size_t id;
+	INT16 special; // Special of the line when the lookup was built
+} linespecial_t;
+
+static linespecial_t *lines_by_special;
+static size_t lines_by_special_capacity;
+static boolean lines_by_special_valid;
+
 /// Adds a tag to a given element's taglist. It will not add a duplicate.
 /// \warning This does not rebuild the global taggroups, which are used for iteration.
 void Tag_Add (taglist_t* list, const mtag_t tag)
@@ -120,14 +133,25 @@ boolean Tag_Compare (const taglist_t* list1, const taglist_t* list2)
 /// Search for an element inside a global taggroup.
 size_t Taggroup_Find (const taggroup_t *group, const size_t id)
 {
-	size_t i;
+	size_t lo = 0, hi;
 
 	if (!group)
 		return -1;
 
-	for (i = 0; i < group->count; i++)
-		if (group->elements[i] == id)
-			return i;
+	// Group elements are kept in ascending order.
+	hi = group->count;
+	while (lo < hi)
+	{
+		size_t mid = lo + (hi - lo) / 2;
+
+		if (group->elements[mid] < id)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	if (lo < group->count && group->elements[lo] == id)
+		return lo;
 
 	return -1;
 }
@@ -201,11 +225,15 @@ void Taggroup_Add (taggroup_t *garray[], const mtag_t tag, size_t id)
 				break;
 	}
 
-	group->elements = Z_Realloc(group->elements, (group->count + 1) * sizeof(size_t), PU_LEVEL, NULL);
+	if (group->count + 1 > group->capacity)
+	{
+		group->capacity = 2 * (group->count + 1);
+		group->elements = Z_Realloc(group->elements, group->capacity * sizeof(size_t), PU_LEVEL, NULL);
+	}
 
 	// Offset existing elements to make room for the new one.
 	if (i < group->count)
-		memmove(&group->elements[i + 1], &group->elements[i], group->count - i);
+		memmove(&group->elements[i + 1], &group->elements[i], (group->count - i) * sizeof(size_t));
 
 	group->count++;
 	group->elements[i] = id;
@@ -258,7 +286,6 @@ void Taggroup_Remove (taggroup_t *garray[], const mtag_t tag, size_t id)
 {
 	taggroup_t *group;
 	size_t rempos;
-	size_t oldcount;
 
 	if (tag == MTAG_GLOBAL)
 		return;
@@ -275,26 +302,16 @@ void Taggroup_Remove (taggroup_t *garray[], const mtag_t tag, size_t id)
 	}
 
 	// Strip away taggroup if no elements left.
-	if (!(oldcount = group->count--))
+	if (!--group->count)
 	{
 		Z_Free(group->elements);
 		Z_Free(group);
 		garray[(UINT16)tag] = NULL;
 	}
-	else
+	else if (rempos < group->count)
 	{
-		size_t *newelements = Z_Malloc(group->count * sizeof(size_t), PU_LEVEL, NULL);
-		size_t i;
-
-		// Copy the previous entries save for the one to remove.
-		for (i = 0; i < rempos; i++)
-			newelements[i] = group->elements[i];
-
-		for (i = rempos + 1; i < oldcount; i++)
-			newelements[i - 1] = group->elements[i];
-
-		Z_Free(group->elements);
-		group->elements = newelements;
+		// Shift the following entries over the one to remove.
+		memmove(&group->elements[rempos], &group->elements[rempos + 1], (group->count - rempos) * sizeof(size_t));
 	}
 }
 
@@ -324,6 +341,9 @@ void Taglist_InitGlobalTables(void)
 	memset(tags_available, 0, sizeof tags_available);
 	num_tags = 0;
 
+	// Line specials are not final yet, they can still be converted from binary.
+	lines_by_special_valid = false;
+
 	for (i = 0; i < MAXTAGS; i++)
 	{
 		tags_sectors[i] = NULL;
@@ -347,6 +367,39 @@ void Taglist_InitGlobalTables(void)
 	}
 }
 
+static int Taglist_CompareLineSpecials(const void *a, const void *b)
+{
+	const linespecial_t *la = a, *lb = b;
+
+	if (la->special != lb->special)
+		return la->special - lb->special;
+
+	return (la->id > lb->id) - (la->id < lb->id);
+}
+
+/// Builds the special to line lookup used by Tag_Iterate_LineSpecial.
+/// Must be called once the line specials are final. Lines whose special is
+/// cleared later stay in the lookup and are skipped when iterating.
+void Taglist_InitLineSpecials(void)
+{
+	size_t i;
+
+	if (numlines > lines_by_special_capacity)
+	{
+		lines_by_special_capacity = numlines;
+		lines_by_special = Z_Realloc(lines_by_special, lines_by_special_capacity * sizeof(linespecial_t), PU_STATIC, NULL);
+	}
+
+	for (i = 0; i < numlines; i++)
+	{
+		lines_by_special[i].id = i;
+		lines_by_special[i].special = lines[i].special;
+	}
+
+	qsort(lines_by_special, numlines, sizeof(linespecial_t), Taglist_CompareLineSpecials);
+	lines_by_special_valid = true;
+}
+
 // Iteration, ingame search.
 
 INT32 Tag_Iterate_Sectors (const mtag_t tag, const size_t p)
@@ -364,16 +417,52 @@ INT32 Tag_Iterate_Things (const mtag_t tag, const size_t p)
 	return Taggroup_Iterate(tags_mapthings, nummapthings, tag, p);
 }
 
+/// Iterate thru the lines with the given special, in ascending order.
+/// Pass the last returned line id + 1 as start to get the next one.
+INT32 Tag_Iterate_LineSpecial (const INT16 special, const size_t start)
+{
+	size_t lo = 0, hi = numlines;
+
+	// Specials are only ever cleared in game, so lines can gain special 0
+	// after the lookup was built.
+	if (!lines_by_special_valid || special == 0)
+	{
+		for (lo = start; lo < numlines; lo++)
+			if (lines[lo].special == special)
+				return lo;
+		return -1;
+	}
+
+	// Find the first line with this special and an id of at least start.
+	while (lo < hi)
+	{
+		size_t mid = lo + (hi - lo) / 2;
+		const linespecial_t *ls = &lines_by_special[mid];
+
+		if (ls->special < special || (ls->special == special && ls->id < start))
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	for (; lo < numlines && lines_by_special[lo].special == special; lo++)
+	{
+		size_t id = lines_by_special[lo].id;
+
+		// Skip lines that had their special changed since.
+		if (lines[id].special == special)
+			return id;
+	}
+
+	return -1;
+}
+
 INT32 Tag_FindLineSpecial(const INT16 special, const mtag_t tag)
 {
 	size_t i;
 
 	if (tag == MTAG_GLOBAL)
-	{
-		for (i = 0; i < numlines; i++)
-			if (lines[i].special == special)
-				return i;
-	}
+		return Tag_Iterate_LineSpecial(special, 0);
 	else if (tags_lines[(UINT16)tag])
 	{
 		taggroup_t *tagged = tags_lines[(UINT16)tag];
@@ -389,15 +478,16 @@ INT32 P_FindSpecialLineFromTag(INT16 special, INT16 tag, INT32 start)
 {
 	if (tag == -1)
 	{
+		INT32 id;
+
 		start++;
 
 		if (start >= (INT32)numlines)
 			return -1;
 
-		while (start < (INT32)numlines && lines[start].special != special)
-			start++;
-
-		return start;
+		// Returns numlines rather than -1 if there are no more, as it always has.
+		id = Tag_Iterate_LineSpecial(special, start);
+		return (id >= 0) ? id : (INT32)numlines;
 	}
 	else
 	{
@@ -69,10 +69,12 @@ INT32 Taggroup_Iterate
 		const size_t p);
 
 void Taglist_InitGlobalTables(void);
+void Taglist_InitLineSpecials(void);
 
 INT32 Tag_Iterate_Sectors (const mtag_t tag, const size_t p);
 INT32 Tag_Iterate_Lines (const mtag_t tag, const size_t p);
 INT32 Tag_Iterate_Things (const mtag_t tag, const size_t p);
+INT32 Tag_Iterate_LineSpecial (const INT16 special, const size_t start);
 
 INT32 Tag_FindLineSpecial(const INT16 special, const mtag_t tag);
 INT32 P_FindSpecialLineFromTag(INT16 special, INT16 tag, INT32 start);
@@ -86,6 +88,9 @@ INT32 P_FindSpecialLineFromTag(INT16 special, INT16 tag, INT32 start);
 #define TAG_ITER_LINES(tag, return_varname)   TAG_ITER(Tag_Iterate_Lines, tag, return_varname)
 #define TAG_ITER_THINGS(tag, return_varname)  TAG_ITER(Tag_Iterate_Things, tag, return_varname)
 
+// Iterates thru all lines with the given special, in ascending order.
+#define SPECIAL_ITER_LINES(special, return_varname) for (return_varname = Tag_Iterate_LineSpecial(special, 0); return_varname >= 0; return_varname = Tag_Iterate_LineSpecial(special, return_varname + 1))
+
 /* ITERATION MACROS
 'tag':
 Pretty much the elements' tag to iterate through.
@@ -86,6 +86,7 @@ consvar_t cv_constextsize = CVAR_INIT ("con_textsize", "Medium", CV_SAVE|CV_CALL
 // local copy of the palette for V_GetColor()
 RGBA_t *pLocalPalette = NULL;
 RGBA_t *pMasterPalette = NULL;
+static palettesearch_t masterpalettesearch; // For NearestColor
 
 /*
 The following was an extremely helpful resource when developing my Colour Cube LUT.
@@ -340,6 +341,8 @@ static void LoadPalette(const char *lumpname)
 		if (Cubeapply)
 			V_CubeApply(&pLocalPalette[i].s.red, &pLocalPalette[i].s.green, &pLocalPalette[i].s.blue);
 	}
+
+	V_InitPaletteSearch(&masterpalettesearch, pMasterPalette);
 }
 
 void V_CubeApply(UINT8 *red, UINT8 *green, UINT8 *blue)
@@ -2645,6 +2648,100 @@ Unoptimized version
 #endif
 }
 
+void V_InitPaletteSearch(palettesearch_t *search, const RGBA_t *palette)
+{
+	INT32 i, j;
+
+	// Insertion sort, stable so equal greens keep palette order
+	for (i = 0; i < 256; i++)
+	{
+		UINT8 g = palette[i].s.green;
+
+		for (j = i; j > 0 && search->green[j-1] > g; j--)
+		{
+			search->red[j] = search->red[j-1];
+			search->green[j] = search->green[j-1];
+			search->blue[j] = search->blue[j-1];
+			search->index[j] = search->index[j-1];
+		}
+
+		search->red[j] = palette[i].s.red;
+		search->green[j] = g;
+		search->blue[j] = palette[i].s.blue;
+		search->index[j] = (UINT8)i;
+	}
+}
+
+// Gives the same result as NearestPaletteColor, including
+// picking the lowest palette index when colors are equally near
+UINT8 V_SearchPaletteColor(const palettesearch_t *search, UINT8 r, UINT8 g, UINT8 b)
+{
+	INT32 lo = 0, hi = 256, mid;
+	INT32 best = INT32_MAX, bestcolor = 0;
+
+	// Start from the first entry at least as green as the color
+	while (lo < hi)
+	{
+		mid = (lo + hi) / 2;
+		if (search->green[mid] < g)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	hi = lo;
+	lo--;
+
+	while (lo >= 0 || hi < 256)
+	{
+		if (hi < 256)
+		{
+			INT32 dg = search->green[hi] - g;
+
+			if (dg*dg > best)
+				hi = 256;
+			else
+			{
+				INT32 dr = search->red[hi] - r, db = search->blue[hi] - b;
+				INT32 distortion = dr*dr + dg*dg + db*db;
+
+				if (distortion < best || (distortion == best && search->index[hi] < bestcolor))
+				{
+					best = distortion;
+					bestcolor = search->index[hi];
+				}
+				hi++;
+			}
+		}
+
+		if (lo >= 0)
+		{
+			INT32 dg = search->green[lo] - g;
+
+			if (dg*dg > best)
+				lo = -1;
+			else
+			{
+				INT32 dr = search->red[lo] - r, db = search->blue[lo] - b;
+				INT32 distortion = dr*dr + dg*dg + db*db;
+
+				if (distortion < best || (distortion == best && search->index[lo] < bestcolor))
+				{
+					best = distortion;
+					bestcolor = search->index[lo];
+				}
+				lo--;
+			}
+		}
+	}
+
+	return (UINT8)bestcolor;
+}
+
+UINT8 V_NearestMasterPaletteColor(UINT8 r, UINT8 g, UINT8 b)
+{
+	return V_SearchPaletteColor(&masterpalettesearch, r, g, b);
+}
+
 // Generates a RGB565 color look-up table
 void InitColorLUT(colorlookup_t *lut, RGBA_t *palette, boolean makecolors)
 {
@@ -2656,22 +2753,20 @@ void InitColorLUT(colorlookup_t *lut, RGBA_t *palette, boolean makecolors)
 
 		lut->init = true;
 		memcpy(lut->palette, palette, palsize);
+		V_InitPaletteSearch(&lut->search, palette);
 
-		for (i = 0; i < 0xFFFF; i++)
+		for (i = 0; i < 0x10000; i++)
 			lut->table[i] = 0xFFFF;
 
 		if (makecolors)
 		{
-			UINT8 r, g, b;
+			INT32 r, g, b;
 
-			for (r = 0; r < 0xFF; r++)
-			for (g = 0; g < 0xFF; g++)
-			for (b = 0; b < 0xFF; b++)
-			{
-				i = CLUTINDEX(r, g, b);
-				if (lut->table[i] == 0xFFFF)
-					lut->table[i] = NearestPaletteColor(r, g, b, palette);
-			}
+			// Each entry gets the color at the low corner of its cell
+			for (r = 0; r < 32; r++)
+			for (g = 0; g < 64; g++)
+			for (b = 0; b < 32; b++)
+				lut->table[(r << 11) | (g << 5) | b] = V_SearchPaletteColor(&lut->search, r << 3, g << 2, b << 3);
 		}
 	}
 }
@@ -2680,7 +2775,7 @@ UINT8 GetColorLUT(colorlookup_t *lut, UINT8 r, UINT8 g, UINT8 b)
 {
 	INT32 i = CLUTINDEX(r, g, b);
 	if (lut->table[i] == 0xFFFF)
-		lut->table[i] = NearestPaletteColor(r, g, b, lut->palette);
+		lut->table[i] = V_SearchPaletteColor(&lut->search, r, g, b);
 	return lut->table[i];
 }
 
@@ -40,6 +40,18 @@ void V_Init(void);
 // Recalculates the viddef (dup, fdup, etc.) according to the current screen resolution.
 void V_Recalc(void);
 
+// Palette sorted by green, so the nearest color search
+// can stop once the green difference alone is too far
+typedef struct
+{
+	UINT8 red[256], green[256], blue[256];
+	UINT8 index[256];
+} palettesearch_t;
+
+void V_InitPaletteSearch(palettesearch_t *search, const RGBA_t *palette);
+UINT8 V_SearchPaletteColor(const palettesearch_t *search, UINT8 r, UINT8 g, UINT8 b);
+UINT8 V_NearestMasterPaletteColor(UINT8 r, UINT8 g, UINT8 b);
+
 // Color look-up table
 #define CLUTINDEX(r, g, b) (((r) >> 3) << 11) | (((g) >> 2) << 5) | ((b) >> 3)
 
@@ -47,7 +59,8 @@ typedef struct
 {
 	boolean init;
 	RGBA_t palette[256];
-	UINT16 table[0xFFFF];
+	palettesearch_t search;
+	UINT16 table[0x10000];
 } colorlookup_t;
 
 void InitColorLUT(colorlookup_t *lut, RGBA_t *palette, boolean makecolors);
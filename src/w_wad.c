@@ -2129,43 +2129,58 @@ size_t W_ReadLumpHeaderPwad(UINT16 wad, UINT16 lump, void *dest, size_t size, si
 #ifdef HAVE_ZLIB
 	case CM_DEFLATE: // Is it compressed via DEFLATE? Very common in ZIPs/PK3s, also what most doom-related editors support.
 		{
-			UINT8 *rawData; // The lump's raw data.
-			UINT8 *decData; // Lump's decompressed real data.
+			// Only inflate as far as the requested range, and read the
+			// compressed data a chunk at a time, so that reading the
+			// header of a lump doesn't mean decompressing all of it.
+			UINT8 *rawData; // A chunk of the lump's raw data.
+			UINT8 *decData; // Lump's decompressed data, up to the end of the range.
 
 			int zErr; // Helper var.
 			z_stream strm;
-			unsigned long rawSize = l->disksize;
-			unsigned long decSize = l->size;
+			size_t rawLeft = l->disksize;
+			size_t rawChunk = min(rawLeft, 16384);
 
-			rawData = Z_Malloc(rawSize, PU_STATIC, NULL);
-			decData = Z_Malloc(decSize, PU_STATIC, NULL);
-
-			if (fread(rawData, 1, rawSize, handle) < rawSize)
-				I_Error("wad %d, lump %d: cannot read compressed data", wad, lump);
+			rawData = Z_Malloc(max(rawChunk, 1), PU_STATIC, NULL);
+			decData = offset ? Z_Malloc(offset + size, PU_STATIC, NULL) : dest;
 
 			strm.zalloc = Z_NULL;
 			strm.zfree = Z_NULL;
 			strm.opaque = Z_NULL;
 
-			strm.total_in = strm.avail_in = rawSize;
-			strm.total_out = strm.avail_out = decSize;
-
+			strm.avail_in = 0;
 			strm.next_in = rawData;
+			strm.avail_out = (uInt)(offset + size);
 			strm.next_out = decData;
 
 			zErr = inflateInit2(&strm, -15);
 			if (zErr == Z_OK)
 			{
-				zErr = inflate(&strm, Z_FINISH);
-				if (zErr == Z_STREAM_END)
+				while (strm.avail_out && zErr == Z_OK)
 				{
-					M_Memcpy(dest, decData, size);
+					if (!strm.avail_in)
+					{
+						size_t chunk = min(rawLeft, rawChunk);
+
+						if (!chunk)
+							break;
+						if (fread(rawData, 1, chunk, handle) < chunk)
+							I_Error("wad %d, lump %d: cannot read compressed data", wad, lump);
+
+						rawLeft -= chunk;
+						strm.next_in = rawData;
+						strm.avail_in = chunk;
+					}
+
+					zErr = inflate(&strm, Z_NO_FLUSH);
 				}
-				else
+
+				if (strm.avail_out)
 				{
 					size = 0;
-					zerr(zErr);
+					zerr(zErr == Z_OK || zErr == Z_STREAM_END ? Z_DATA_ERROR : zErr);
 				}
+				else if (offset)
+					M_Memcpy(dest, decData + offset, size);
 
 				(void)inflateEnd(&strm);
 			}
@@ -2176,7 +2191,8 @@ size_t W_ReadLumpHeaderPwad(UINT16 wad, UINT16 lump, void *dest, size_t size, si
 			}
 
 			Z_Free(rawData);
-			Z_Free(decData);
+			if (offset)
+				Z_Free(decData);
 
 			return size;
 		}
@@ -2422,9 +2438,40 @@ boolean W_ReadPatchHeaderPwad(UINT16 wadnum, UINT16 lumpnum, INT16 *width, INT16
 	if (Picture_IsLumpPNG(header, len))
 	{
 #ifndef NO_PNG_LUMPS
-		UINT8 *png = W_CacheLumpNumPwad(wadnum, lumpnum, PU_CACHE);
-
 		INT32 pwidth = 0, pheight = 0;
+		size_t readsize = 512;
+
+		// The grAb chunk is almost always right after the header,
+		// so try not to read and inflate the whole image for it
+		for (;;)
+		{
+			UINT8 *prefix;
+			INT32 found;
+
+			readsize = min(readsize, len);
+			prefix = Z_Malloc(readsize, PU_STATIC, NULL);
+			if (W_ReadLumpHeaderPwad(wadnum, lumpnum, prefix, readsize, 0) != readsize)
+			{
+				// Short read, leave it to the full lump path below
+				Z_Free(prefix);
+				break;
+			}
+			found = Picture_PNGHeaderDimensions(prefix, readsize, &pwidth, &pheight, topoffset, leftoffset);
+			Z_Free(prefix);
+
+			if (found == 1)
+			{
+				*width = (INT16)pwidth;
+				*height = (INT16)pheight;
+				return true;
+			}
+			if (found == -1 || readsize == len)
+				break;
+			readsize *= 8;
+		}
+
+		// Let libpng have a go, and complain about it
+		UINT8 *png = W_CacheLumpNumPwad(wadnum, lumpnum, PU_CACHE);
 
 		if (!Picture_PNGDimensions(png, &pwidth, &pheight, topoffset, leftoffset, len))
 		{